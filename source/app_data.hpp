@@ -5,5 +5,6 @@ namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline static constexpr std::string_view name = "lltool"sv;
 inline static constexpr std::string_view descr = "A tool capable to manipulate LogicLab files"sv;
+inline static constexpr std::string_view build_id = __DATE__ " " __TIME__ ""sv;
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -5,10 +5,13 @@
 //  #include "arguments.hpp" // app::Arguments
 //  ---------------------------------------------
 #include <stdexcept> // std::runtime_error, std::invalid_argument
+#include <limits> // std::numeric_limits
 #include <ranges> // std::ranges::any_of
 #include <format>
 #include <print>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <filesystem> // std::filesystem
 namespace fs = std::filesystem;
 using namespace std::literals; // "..."sv
@@ -17,7 +20,11 @@ using namespace std::literals; // "..."sv
 #include "file_globbing.hpp" // MG::file_glob()
 #include "has_duplicate_basenames.hpp" // MG::find_duplicate_basename()
 #include "options_map.hpp" // MG::options_map
+#include "string_conversions.hpp" // str::to_num_or<>()
+#include "parallel_tasks.hpp" // MG::get_hardware_threads_count()
+#include "expand_env_vars.hpp" // sys::resolve_var_getenv()
 #include "app_data.hpp" // app::name, app::descr
+#include "conversion_target.hpp" // ll::conversion_target_t
 
 
 namespace app //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -28,40 +35,85 @@ class Arguments final
 {
     class task_t final
     {
-        enum en_task_t : char { NONE, UPDATE, CONVERT } m_value = NONE;
+        enum en_task_t : char { NONE, UPDATE, CONVERT, EXTRACT, BATCH, SERVE } m_value = NONE;
 
      public:
         void set_as_update() noexcept { m_value=UPDATE; }
         void set_as_convert() noexcept { m_value=CONVERT; }
+        void set_as_extract() noexcept { m_value=EXTRACT; }
+        void set_as_batch() noexcept { m_value=BATCH; }
+        void set_as_serve() noexcept { m_value=SERVE; }
 
         [[nodiscard]] bool is_update() const noexcept { return m_value==UPDATE; }
         [[nodiscard]] bool is_convert() const noexcept { return m_value==CONVERT; }
+        [[nodiscard]] bool is_extract() const noexcept { return m_value==EXTRACT; }
+        [[nodiscard]] bool is_batch() const noexcept { return m_value==BATCH; }
+        [[nodiscard]] bool is_serve() const noexcept { return m_value==SERVE; }
     };
 
  private:
-    fs::path m_prj_path;
+    std::vector<fs::path> m_prj_paths;
+    fs::path m_prj_path; // The first one
+    fs::path m_jobs_path; // "-" for stdin
+    fs::path m_socket_path; // Of the server
+    std::vector<std::string> m_job_args; // To forward the task to the server
     std::vector<fs::path> m_input_files;
+    std::vector<fs::path> m_input_globs; // As given, before expansion
+    std::vector<fs::path> m_sources_files; // Of the libraries to convert while updating
     fs::path m_out_path;
+    fs::path m_cache_dir; // Of the conversions outputs
+    std::uintmax_t m_cache_max_size = 1024u * 1024u * 1024u;
     MG::options_map m_options;
+    std::vector<ll::conversion_target_t> m_targets; // Outputs with their own options
+    std::vector<std::string> m_targets_options; // As given, applied over the common ones
     task_t m_task;
+    unsigned int m_threads_count = 1u; // Parallel jobs
     bool m_verbose = false; // More info to stdout
     bool m_quiet = false; // No user interaction
     bool m_force = false; // Overwrite or clear existing output files
+    bool m_incremental = false; // Convert just the changed files
+    bool m_watch = false; // Stay resident converting the changed files
+    bool m_pipeline = false; // Overlap mapping, parsing and writing
 
  public:
     [[nodiscard]] const auto& prj_path() const noexcept { return m_prj_path; }
+    [[nodiscard]] const auto& prj_paths() const noexcept { return m_prj_paths; }
+    [[nodiscard]] const auto& jobs_path() const noexcept { return m_jobs_path; }
+    [[nodiscard]] const auto& socket_path() const noexcept { return m_socket_path; }
     [[nodiscard]] const auto& input_files() const noexcept { return m_input_files; }
+    [[nodiscard]] const auto& input_globs() const noexcept { return m_input_globs; }
+    [[nodiscard]] const auto& sources_files() const noexcept { return m_sources_files; }
     [[nodiscard]] const auto& out_path() const noexcept { return m_out_path; }
+    [[nodiscard]] bool streamed() const noexcept { return m_prj_path=="-" or m_out_path=="-"; } // Project from stdin or to stdout
+    [[nodiscard]] const auto& cache_dir() const noexcept { return m_cache_dir; }
+    [[nodiscard]] std::uintmax_t cache_max_size() const noexcept { return m_cache_max_size; }
     [[nodiscard]] const auto& options() const noexcept { return m_options; }
+    [[nodiscard]] const auto& targets() const noexcept { return m_targets; }
     [[nodiscard]] const auto& task() const noexcept { return m_task; }
+    [[nodiscard]] unsigned int threads_count() const noexcept { return m_threads_count; }
     [[nodiscard]] bool verbose() const noexcept { return m_verbose; }
     [[nodiscard]] bool quiet() const noexcept { return m_quiet; }
     [[nodiscard]] bool overwrite_existing() const noexcept { return m_force; }
+    [[nodiscard]] bool incremental() const noexcept { return m_incremental; }
+    [[nodiscard]] bool watch() const noexcept { return m_watch; }
+    [[nodiscard]] bool pipeline() const noexcept { return m_pipeline; }
+
+    // More input files given, or to come when watching
+    [[nodiscard]] bool converts_many_files() const
+       {
+        return input_files().size()>1u or (watch() and std::ranges::any_of(input_globs(), [](const fs::path& pth){ return MG::contains_wildcards(pth.filename().string()); }));
+       }
 
  public:
     //-----------------------------------------------------------------------
     void parse(const int argc, const char* const argv[])
        {
+        for( int i=1; i<argc; ++i )
+           {// Except the socket, that is not part of the task
+            if( argv[i]=="--socket"sv ) ++i;
+            else m_job_args.emplace_back(argv[i]);
+           }
+
         MG::args_extractor args(argc, argv);
         args.apply_switch_by_name_or_char = [this](const std::string_view full_name, const char brief_name) { apply_switch(full_name,brief_name); };
 
@@ -76,6 +128,18 @@ class Arguments final
                {
                 m_task.set_as_convert();
                }
+            else if( arg=="extract"sv )
+               {
+                m_task.set_as_extract();
+               }
+            else if( arg=="batch"sv )
+               {
+                m_task.set_as_batch();
+               }
+            else if( arg=="serve"sv )
+               {
+                m_task.set_as_serve();
+               }
             else if( arg=="help"sv )
                {
                 print_help_and_exit();
@@ -93,6 +157,13 @@ class Arguments final
             while( args.has_data() )
                {
                 arg = args.current();
+                if( arg=="--socket"sv )
+                   {
+                    m_socket_path = args.get_next_value_of(arg);
+                    args.next();
+                    continue;
+                   }
+
                 if( args.is_switch(arg) )
                    {
                     if( arg=="--to"sv or arg=="--out"sv or arg=="-o"sv )
@@ -108,6 +179,43 @@ class Arguments final
                        {
                         m_options.assign( args.get_next_value_of(arg) );
                        }
+                    else if( arg=="--jobs"sv or arg=="-j"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        const auto num = str::to_num_or<unsigned int>(str);
+                        if( not num.has_value() )
+                           {
+                            throw std::invalid_argument{ std::format("Invalid jobs number: {}", num.error()) };
+                           }
+                        m_threads_count = num.value()>0u ? num.value() : MG::get_hardware_threads_count();
+                       }
+                    else if( arg=="--target"sv )
+                       {// <output directory>=<options>
+                        const std::string_view str = args.get_next_value_of(arg);
+                        const std::size_t i_eq = str.find('=');
+                        m_targets.push_back( ll::conversion_target_t{ fs::path{str.substr(0, i_eq)}, {} } );
+                        m_targets_options.emplace_back( i_eq==std::string_view::npos ? std::string_view{} : str.substr(i_eq+1u) );
+                       }
+                    else if( arg=="--sources"sv )
+                       {// Can be repeated
+                        const auto sources_paths = MG::file_glob( fs::path(args.get_next_value_of(arg)) );
+                        m_sources_files.insert(m_sources_files.end(), sources_paths.cbegin(), sources_paths.cend());
+                       }
+                    else if( arg=="--cache-dir"sv )
+                       {
+                        m_cache_dir = args.get_next_value_of(arg);
+                       }
+                    else if( arg=="--cache-size"sv )
+                       {
+                        const std::string_view str = args.get_next_value_of(arg);
+                        const auto num = str::to_num_or<std::uintmax_t>(str);
+                        constexpr std::uintmax_t bytes_per_mb = 1024u * 1024u;
+                        if( not num.has_value() or num.value()==0u or num.value()>std::numeric_limits<std::uintmax_t>::max()/bytes_per_mb )
+                           {
+                            throw std::invalid_argument{ std::format("Invalid cache size: {}", str) };
+                           }
+                        m_cache_max_size = num.value() * bytes_per_mb;
+                       }
                     else
                        {
                         args.apply_switch(arg);
@@ -115,21 +223,34 @@ class Arguments final
                    }
                 else
                    {// Expecting input path
-                    if( task().is_update() )
-                       {// Must be the project path
-                        if( not m_prj_path.empty() )
-                           {// This must be the project path
-                            throw std::invalid_argument{ std::format("Project file was already set to {}", m_prj_path.string()) };
+                    if( task().is_update() or task().is_extract() )
+                       {// Must be a project path
+                        const fs::path prj_path{arg};
+                        if( prj_path!="-" and not fs::exists(prj_path) )
+                           {
+                            throw std::invalid_argument{ std::format("Project file not found: {}", prj_path.string()) };
                            }
-
-                        m_prj_path = arg;
-                        if( not fs::exists(m_prj_path) )
+                        if( std::ranges::any_of(m_prj_paths, [&prj_path](const fs::path& pth){ return pth==prj_path or (pth!="-" and prj_path!="-" and fs::equivalent(pth, prj_path)); }) )
+                           {
+                            throw std::invalid_argument{ std::format("Project file {} was already given", prj_path.string()) };
+                           }
+                        if( m_prj_paths.empty() )
+                           {
+                            m_prj_path = prj_path;
+                           }
+                        m_prj_paths.push_back(prj_path);
+                       }
+                    else if( task().is_batch() )
+                       {// Must be the jobs file
+                        if( not m_jobs_path.empty() )
                            {
-                            throw std::invalid_argument{ std::format("Project file not found: {}", m_prj_path.string()) };
+                            throw std::invalid_argument{ std::format("Jobs file was already set to {}", m_jobs_path.string()) };
                            }
+                        m_jobs_path = arg;
                        }
                     else if( task().is_convert() )
                        {// Must be the input file(s)
+                        m_input_globs.emplace_back(arg);
                       #ifdef __cpp_lib_containers_ranges
                         m_input_files.append_range( MG::file_glob( fs::path(arg) ) );
                       #else
@@ -146,6 +267,33 @@ class Arguments final
         check_and_postprocess();
        }
 
+    //-----------------------------------------------------------------------
+    // The task as a line of a jobs batch
+    [[nodiscard]] std::string job_line() const
+       {
+        std::string line;
+        for( const auto& arg : m_job_args )
+           {
+            if( not line.empty() ) line += ' ';
+            if( arg.find_first_of(" \t\"'"sv)==std::string::npos ) line += arg;
+            else if( arg.contains('"') ) line += std::format("'{}'", arg);
+            else line += std::format("\"{}\"", arg);
+           }
+        line += '\n';
+        return line;
+       }
+
+    //-----------------------------------------------------------------------
+    // Arguments not including the program name
+    void parse(const std::vector<std::string>& args)
+       {
+        std::vector<const char*> argv;
+        argv.reserve(args.size()+1u);
+        argv.push_back( app::name.data() );
+        for( const auto& arg : args ) argv.push_back( arg.c_str() );
+        parse(static_cast<int>(argv.size()), argv.data());
+       }
+
     //-----------------------------------------------------------------------
     void check_and_postprocess()
        {
@@ -156,31 +304,134 @@ class Arguments final
                 throw std::invalid_argument{"Project file not given"};
                }
 
-            if( fs::exists(out_path()) and fs::is_directory(out_path()) )
+            if( const auto dup = MG::find_duplicate_basename(sources_files()); dup.has_value() )
+               {
+                throw std::invalid_argument{ std::format("Two or more sources have the same name \"{}\"", dup.value()) };
+               }
+
+            if( prj_paths().size()>1u and not out_path().empty() )
                {
-                m_out_path /= prj_path().filename();
+                throw std::invalid_argument{"Can't specify an output when updating more projects (updated in place)"};
                }
 
-            if( fs::exists(out_path()) and fs::is_regular_file(out_path()) )
-               {// I'll ensure to not overwrite the existing output file without specific intention
-                if( fs::equivalent(prj_path(), out_path()) )
+            if( streamed() )
+               {
+                if( prj_paths().size()>1u )
+                   {
+                    throw std::invalid_argument{"Can't update more projects when streaming"};
+                   }
+                if( out_path().empty() )
                    {
-                    throw std::invalid_argument{ std::format("Project file \"{}\" can't be explicitly set as output", out_path().string()) };
+                    throw std::invalid_argument{"Specify the output of the project read from stdin (--to -)"};
                    }
-                else if( not overwrite_existing() )
+                if( out_path()!="-" and fs::exists(out_path()) and not overwrite_existing() )
                    {
                     throw std::invalid_argument{ std::format("Won't overwrite existing file \"{}\" (unless you --force me)", out_path().string()) };
                    }
                }
+            else
+               {
+                if( fs::exists(out_path()) and fs::is_directory(out_path()) )
+                   {
+                    m_out_path /= prj_path().filename();
+                   }
+
+                if( fs::exists(out_path()) and fs::is_regular_file(out_path()) )
+                   {// I'll ensure to not overwrite the existing output file without specific intention
+                    if( fs::equivalent(prj_path(), out_path()) )
+                       {
+                        throw std::invalid_argument{ std::format("Project file \"{}\" can't be explicitly set as output", out_path().string()) };
+                       }
+                    else if( not overwrite_existing() )
+                       {
+                        throw std::invalid_argument{ std::format("Won't overwrite existing file \"{}\" (unless you --force me)", out_path().string()) };
+                       }
+                   }
+               }
+           }
+        else if( task().is_extract() )
+           {
+            if( prj_path().empty() )
+               {
+                throw std::invalid_argument{"Project file not given"};
+               }
+            if( prj_paths().size()>1u )
+               {
+                throw std::invalid_argument{"Can extract the libraries of just one project"};
+               }
+            if( streamed() )
+               {
+                throw std::invalid_argument{"Can't extract the libraries from stdin or to stdout"};
+               }
+            if( out_path().empty() )
+               {
+                throw std::invalid_argument{"Output directory not given"};
+               }
+            if( fs::exists(out_path()) and not fs::is_directory(out_path()) )
+               {
+                throw std::invalid_argument{ std::format("Output should be a directory: \"{}\"", out_path().string()) };
+               }
            }
         else if( task().is_convert() )
            {
-            if( input_files().empty() )
+            if( not targets().empty() or pipeline() )
+               {// These conversions don't use the outputs cache
+                if( not cache_dir().empty() )
+                   {
+                    throw std::invalid_argument{"The outputs cache is not supported with targets or in pipeline mode"};
+                   }
+               }
+            else if( cache_dir().empty() )
                {
+                if( const auto dir = sys::resolve_var_getenv("LLTOOL_CACHE_DIR"); dir.has_value() )
+                   {
+                    m_cache_dir = dir.value();
+                   }
+               }
+
+            if( input_files().empty() and not (watch() and not input_globs().empty()) )
+               {// When watching could be created later
                 throw std::invalid_argument{"No input files given"};
                }
 
-            else if( input_files().size()>1u  )
+            if( not targets().empty() )
+               {
+                if( not out_path().empty() )
+                   {
+                    throw std::invalid_argument{"Give the output directories either with --to or with --target"};
+                   }
+                if( incremental() or watch() or pipeline() )
+                   {
+                    throw std::invalid_argument{"Targets are not supported in incremental, watch or pipeline mode"};
+                   }
+                for( std::size_t i=0; i<m_targets.size(); ++i )
+                   {// Are output directories, as when converting multiple files
+                    const fs::path& dir = m_targets[i].output_path;
+                    for( std::size_t j=0; j<i; ++j )
+                       {// Would write the same files
+                        if( fs::weakly_canonical(m_targets[j].output_path)==fs::weakly_canonical(dir) )
+                           {
+                            throw std::invalid_argument{ std::format("Target directory \"{}\" was already given", dir.string()) };
+                           }
+                       }
+                    if( fs::exists(dir) and fs::is_directory(dir) and std::ranges::any_of(input_files(), [&dir](const fs::path& input_file_path){return fs::equivalent(dir, input_file_path.parent_path());}) )
+                       {
+                        throw std::runtime_error{ std::format("Output directory \"{}\" contains input files", dir.string()) };
+                       }
+                    m_targets[i].options = m_options;
+                    m_targets[i].options.assign( m_targets_options[i] );
+                   }
+                if( const auto dup = MG::find_duplicate_basename(input_files()); dup.has_value() )
+                   {
+                    throw std::runtime_error{ std::format("Two or more input files have the same name \"{}\"", dup.value()) };
+                   }
+               }
+            else if( incremental() and (out_path().empty() or (fs::exists(out_path()) and not fs::is_directory(out_path()))) )
+               {// The manifest lives in the output directory
+                throw std::invalid_argument{"An output directory is needed for incremental conversion"};
+               }
+
+            if( targets().empty() and converts_many_files() )
                {// If converting multiple files...
                 //...An output directory must be specified
                 if( out_path().empty() )
@@ -201,10 +452,43 @@ class Arguments final
                    }
                }
            }
+        else if( task().is_serve() )
+           {
+            if( socket_path().empty() )
+               {
+                throw std::invalid_argument{"Socket path not given"};
+               }
+           }
+        else if( task().is_batch() )
+           {
+            if( jobs_path().empty() )
+               {
+                throw std::invalid_argument{"Jobs file not given"};
+               }
+            else if( jobs_path()!="-" and not fs::exists(jobs_path()) )
+               {
+                throw std::invalid_argument{ std::format("Jobs file not found: {}", jobs_path().string()) };
+               }
+           }
         else
            {
             throw std::invalid_argument{"No task selected"};
            }
+
+        if( watch() and not task().is_convert() )
+           {
+            throw std::invalid_argument{"Can watch just the files to convert"};
+           }
+
+        if( not sources_files().empty() and not task().is_update() )
+           {
+            throw std::invalid_argument{"Sources can be given just when updating a project"};
+           }
+
+        if( pipeline() and (not task().is_convert() or threads_count()>1u or incremental() or watch()) )
+           {
+            throw std::invalid_argument{"Pipeline is a plain conversion mode, not combinable with --jobs, --incremental or --watch"};
+           }
        }
 
     //-----------------------------------------------------------------------
@@ -220,12 +504,25 @@ class Arguments final
     static void print_usage()
        {
         std::print( "\nUsage:\n"
-                    "   {0} [convert|update|help] [switches] [path(s)]\n"
+                    "   {0} [convert|update|extract|batch|help] [switches] [path(s)]\n"
                     "   {0} convert path/to/*.h --force --to path/to/outdir\n"
-                    "   {0} update path/to/project.ppjs\n"
+                    "   {0} update path/to/project.ppjs [path/to/other/project.plcprj ...]\n"
+                    "   {0} update - --to - (Stream an UTF-8 project from stdin to stdout)\n"
+                    "   {0} extract path/to/project.ppjs --to path/to/outdir\n"
+                    "   {0} batch path/to/jobs.txt (- for stdin, a task per line, 'wait' to sync)\n"
+                    "   {0} serve --socket path/to/lltool.sock\n"
                     "       --to/--out/-o (Specify output file/directory)\n"
                     "       --options/-p (Specify options, ex: plclib-schemaver:2.8,plclib-indent:3,sort,timestamp)\n"
+                    "       --sources (Libraries sources to convert while updating, ex: src/*.h)\n"
+                    "       --target (An output directory with additional options, ex: out/v26=plclib-schemaver:2.6)\n"
+                    "       --jobs/-j (Number of parallel conversions, 0 to use all cores)\n"
                     "       --force/-F (Overwrite/clear output files)\n"
+                    "       --incremental/-i (Convert just the files changed since last run)\n"
+                    "       --cache-dir (Reuse the outputs stored here, default from LLTOOL_CACHE_DIR)\n"
+                    "       --cache-size (Limit of the cache size in MB, default 1024)\n"
+                    "       --watch/-w (Stay resident converting the files when written)\n"
+                    "       --pipeline (Overlap mapping, parsing and writing of consecutive files)\n"
+                    "       --socket (Serve or send the task to a server listening on this socket)\n"
                     "       --verbose/-v (Print more info on stdout)\n"
                     "       --quiet/-q (No user interaction)\n"
                     "\n", app::name );
@@ -239,6 +536,18 @@ class Arguments final
            {
             m_force = true;
            }
+        else if( full_name=="incremental"sv or brief_name=='i' )
+           {
+            m_incremental = true;
+           }
+        else if( full_name=="watch"sv or brief_name=='w' )
+           {
+            m_watch = true;
+           }
+        else if( full_name=="pipeline"sv )
+           {
+            m_pipeline = true;
+           }
         else if( full_name=="verbose"sv or brief_name=='v' )
            {
             m_verbose = true;
@@ -0,0 +1,153 @@
+#pragma once
+//  ---------------------------------------------
+//  A blocking queue with limited capacity
+//  to connect producer and consumer threads
+//  ---------------------------------------------
+//  #include "bounded_queue.hpp" // MG::bounded_queue<>
+//  ---------------------------------------------
+#include <deque>
+#include <optional>
+#include <mutex> // std::mutex, std::unique_lock
+#include <condition_variable> // std::condition_variable
+#include <algorithm> // std::max
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+struct queue_stats_t final
+   {
+    std::size_t pushed_count = 0u;
+    std::size_t max_depth = 0u;
+    std::size_t depths_sum = 0u; // Sampled at each push
+    std::size_t full_count = 0u; // Times the producer had to wait
+
+    [[nodiscard]] double average_depth() const noexcept
+       {
+        return pushed_count>0u ? static_cast<double>(depths_sum) / static_cast<double>(pushed_count) : 0.0;
+       }
+   };
+
+
+/////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class bounded_queue final
+{
+ public:
+    using stats_t = queue_stats_t;
+
+ private:
+    std::deque<T> m_items;
+    const std::size_t m_capacity;
+    bool m_closed = false;
+    stats_t m_stats;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+
+ public:
+    explicit bounded_queue(const std::size_t capacity) noexcept
+      : m_capacity{ std::max<std::size_t>(capacity, 1u) }
+       {}
+
+    //-----------------------------------------------------------------------
+    // Blocks while full, returns false if closed
+    bool push(T&& item)
+       {
+           {std::unique_lock lock(m_mutex);
+            if( m_items.size()>=m_capacity and not m_closed )
+               {
+                ++m_stats.full_count;
+                m_not_full.wait(lock, [this]{ return m_items.size()<m_capacity or m_closed; });
+               }
+            if( m_closed )
+               {
+                return false;
+               }
+            m_items.push_back( std::move(item) );
+            ++m_stats.pushed_count;
+            m_stats.depths_sum += m_items.size();
+            m_stats.max_depth = std::max(m_stats.max_depth, m_items.size());
+           }
+        m_not_empty.notify_one();
+        return true;
+       }
+
+    //-----------------------------------------------------------------------
+    // Blocks while empty, returns nothing when closed and empty
+    [[nodiscard]] std::optional<T> pop()
+       {
+        std::optional<T> item;
+           {std::unique_lock lock(m_mutex);
+            m_not_empty.wait(lock, [this]{ return not m_items.empty() or m_closed; });
+            if( m_items.empty() )
+               {
+                return item;
+               }
+            item.emplace( std::move(m_items.front()) );
+            m_items.pop_front();
+           }
+        m_not_full.notify_one();
+        return item;
+       }
+
+    //-----------------------------------------------------------------------
+    // No more items will be pushed, the pending ones can still be popped
+    void close()
+       {
+           {std::scoped_lock lock(m_mutex);
+            m_closed = true;
+           }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+       }
+
+    [[nodiscard]] stats_t stats() const
+       {
+        std::scoped_lock lock(m_mutex);
+        return m_stats;
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::bounded_queue"> bounded_queue_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::bounded_queue") = []
+   {
+    MG::bounded_queue<int> queue(2u);
+    std::vector<int> popped;
+       {std::jthread consumer([&]
+           {
+            while( const auto item = queue.pop() )
+               {
+                popped.push_back( item.value() );
+               }
+           });
+        for( int i=0; i<100; ++i )
+           {
+            ut::expect( queue.push(int{i}) );
+           }
+        queue.close();
+       }
+
+    ut::expect( ut::that % popped.size()==100u );
+    ut::expect( std::ranges::is_sorted(popped) );
+    ut::expect( ut::that % queue.stats().pushed_count==100u );
+    ut::expect( ut::that % queue.stats().max_depth<=2u );
+    ut::expect( not queue.push(int{100}) ) << "closed queue should refuse items\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,157 @@
+#pragma once
+//  ---------------------------------------------
+//  A fast non cryptographic 64 bit hash of a
+//  byte sequence, to detect content changes
+//  ---------------------------------------------
+//  #include "bytes_hash.hpp" // MG::bytes_hasher, MG::hash_of()
+//  ---------------------------------------------
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <string_view>
+#include <format>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Consumes eight bytes at a time, the result doesn't depend on
+// how the data is split among the update() calls
+class bytes_hasher final
+{
+ private:
+    std::uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    std::uint64_t m_total_size = 0u;
+    char m_tail[8] {};
+    std::size_t m_tail_size = 0u;
+
+ public:
+    constexpr bytes_hasher& update(std::string_view bytes) noexcept
+       {
+        m_total_size += bytes.size();
+
+        if( m_tail_size>0u )
+           {// Complete the pending word
+            while( m_tail_size<sizeof(m_tail) and not bytes.empty() )
+               {
+                m_tail[m_tail_size++] = bytes.front();
+                bytes.remove_prefix(1);
+               }
+            if( m_tail_size<sizeof(m_tail) )
+               {
+                return *this;
+               }
+            mix( load_word(m_tail) );
+            m_tail_size = 0u;
+           }
+
+        while( bytes.size()>=sizeof(std::uint64_t) )
+           {
+            mix( load_word(bytes.data()) );
+            bytes.remove_prefix(sizeof(std::uint64_t));
+           }
+
+        // Less than a word remains
+        while( m_tail_size<sizeof(m_tail) and not bytes.empty() )
+           {
+            m_tail[m_tail_size++] = bytes.front();
+            bytes.remove_prefix(1);
+           }
+        return *this;
+       }
+
+    [[nodiscard]] constexpr std::uint64_t digest() const noexcept
+       {
+        std::uint64_t h = m_state;
+        if( m_tail_size>0u )
+           {
+            char last[8] {};
+            for( std::size_t i=0; i<m_tail_size; ++i ) last[i] = m_tail[i];
+            h = mixed(h, load_word(last));
+           }
+        h = mixed(h, m_total_size);
+        // Final avalanche
+        h ^= h >> 33u;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33u;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33u;
+        return h;
+       }
+
+ private:
+    constexpr void mix(const std::uint64_t word) noexcept
+       {
+        m_state = mixed(m_state, word);
+       }
+
+    [[nodiscard]] static constexpr std::uint64_t mixed(std::uint64_t h, std::uint64_t word) noexcept
+       {
+        word *= 0x87C37B91114253D5ull;
+        word = (word << 31u) | (word >> 33u);
+        word *= 0x4CF5AD432745937Full;
+        h ^= word;
+        h = (h << 27u) | (h >> 37u);
+        return h * 5u + 0x52DCE729u;
+       }
+
+    [[nodiscard]] static constexpr std::uint64_t load_word(const char* const p) noexcept
+       {// Little endian composition, independent from host
+        std::uint64_t word = 0u;
+        for( std::size_t i=0; i<sizeof(std::uint64_t); ++i )
+           {
+            word |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8u*i);
+           }
+        return word;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] constexpr std::uint64_t hash_of(const std::string_view bytes) noexcept
+{
+    return bytes_hasher{}.update(bytes).digest();
+}
+
+//---------------------------------------------------------------------------
+[[nodiscard]] inline std::string to_hex(const std::uint64_t hash)
+{
+    return std::format("{:016x}", hash);
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::bytes_hasher"> bytes_hash_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::hash_of()") = []
+   {
+    ut::expect( ut::that % MG::hash_of(""sv)!=MG::hash_of("\0"sv) );
+    ut::expect( ut::that % MG::hash_of("abc"sv)==MG::hash_of("abc"sv) );
+    ut::expect( ut::that % MG::hash_of("abc"sv)!=MG::hash_of("abd"sv) );
+    ut::expect( ut::that % MG::hash_of("0123456789abcdef"sv)!=MG::hash_of("0123456789abcdeg"sv) );
+    ut::expect( ut::that % MG::to_hex(0x1234u)=="0000000000001234"sv );
+   };
+
+ut::test("MG::bytes_hasher split updates") = []
+   {
+    const std::string_view content = "The quick brown fox jumps over the lazy dog"sv;
+    const auto expected = MG::hash_of(content);
+    for( std::size_t i=0; i<=content.size(); ++i )
+       {
+        MG::bytes_hasher hasher;
+        hasher.update(content.substr(0,i)).update(content.substr(i));
+        ut::expect( ut::that % hasher.digest()==expected ) << "split at " << i << '\n';
+       }
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
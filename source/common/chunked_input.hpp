@@ -0,0 +1,137 @@
+#pragma once
+//  ---------------------------------------------
+//  A window over an input read by chunks (ex.
+//  a pipe), keeping in memory just the bytes
+//  still in use
+//  ---------------------------------------------
+//  #include "chunked_input.hpp" // sys::chunked_input
+//  ---------------------------------------------
+#include <cassert>
+#include <cstdio> // std::FILE, std::fread
+#include <functional> // std::function
+#include <stdexcept> // std::runtime_error
+#include <string>
+#include <string_view>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The views of bytes() are invalidated by read_more(), the users pin
+// the bytes they still need passing the input offset to keep from
+class chunked_input final
+{
+ public:
+    // Fills the given buffer, returns the read bytes (zero at the end)
+    using read_t = std::function<std::size_t(char*, std::size_t)>;
+    static constexpr std::size_t default_chunk_size = 256u * 1024u;
+
+ private:
+    read_t m_read;
+    std::string m_buf;
+    std::size_t m_base_offset = 0u; // Input offset of the first byte in m_buf
+    std::size_t m_chunk_size;
+    bool m_ended = false;
+
+ public:
+    explicit chunked_input(read_t&& read, const std::size_t chunk_size =default_chunk_size) noexcept
+      : m_read{std::move(read)}
+      , m_chunk_size{chunk_size}
+       {
+        assert( m_chunk_size>0u );
+       }
+
+    //-----------------------------------------------------------------------
+    // Reading from an already open stream (ex. stdin), that won't be closed
+    [[nodiscard]] static chunked_input from_stream(std::FILE* const stream, const std::size_t chunk_size =default_chunk_size) noexcept
+       {
+        return chunked_input([stream](char* const buf, const std::size_t size) -> std::size_t
+           {
+            const std::size_t n = std::fread(buf, 1, size, stream);
+            if( n==0u and std::ferror(stream) )
+               {
+                throw std::runtime_error{"Cannot read the input stream"};
+               }
+            return n;
+           }, chunk_size);
+       }
+
+    //-----------------------------------------------------------------------
+    // Reading from a buffer by chunks of the given size
+    [[nodiscard]] static chunked_input from_bytes(const std::string_view bytes, const std::size_t chunk_size =default_chunk_size) noexcept
+       {
+        return chunked_input([bytes, pos = std::size_t{0u}](char* const buf, const std::size_t size) mutable noexcept -> std::size_t
+           {
+            const std::string_view chunk = bytes.substr(pos, size);
+            chunk.copy(buf, chunk.size());
+            pos += chunk.size();
+            return chunk.size();
+           }, chunk_size);
+       }
+
+    [[nodiscard]] std::string_view bytes() const noexcept { return m_buf; }
+    [[nodiscard]] std::size_t base_offset() const noexcept { return m_base_offset; }
+    [[nodiscard]] std::size_t end_offset() const noexcept { return m_base_offset + m_buf.size(); }
+    [[nodiscard]] bool ended() const noexcept { return m_ended; }
+
+    //-----------------------------------------------------------------------
+    // Forget the bytes before the given input offset and append another
+    // chunk, returns false if there's nothing more to read
+    [[nodiscard]] bool read_more(const std::size_t keep_from_offset)
+       {
+        assert( keep_from_offset>=m_base_offset and keep_from_offset<=end_offset() );
+        if( m_ended )
+           {
+            return false;
+           }
+        m_buf.erase(0, keep_from_offset - m_base_offset);
+        m_base_offset = keep_from_offset;
+
+        const std::size_t prev_size = m_buf.size();
+        m_buf.resize(prev_size + m_chunk_size);
+        std::size_t n = 0u;
+        try{
+            n = m_read(m_buf.data()+prev_size, m_chunk_size);
+           }
+        catch(...)
+           {
+            m_buf.resize(prev_size);
+            throw;
+           }
+        m_buf.resize(prev_size + n);
+        if( n==0u )
+           {
+            m_ended = true;
+            return false;
+           }
+        return true;
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::chunked_input"> chunked_input_tests = []
+{////////////////////////////////////////////////////////////////////////////
+using ut::expect;
+using ut::that;
+
+ut::test("reading by chunks") = []
+   {
+    sys::chunked_input input = sys::chunked_input::from_bytes("abcdefgh"sv, 3u);
+    expect( input.bytes().empty() and not input.ended() );
+    expect( input.read_more(0u) and input.bytes()=="abc"sv );
+    expect( input.read_more(0u) and input.bytes()=="abcdef"sv ) << "should keep the pinned bytes\n";
+    expect( input.read_more(4u) and input.bytes()=="efgh"sv and that % input.base_offset()==4u );
+    expect( not input.read_more(8u) and input.bytes().empty() and input.ended() );
+    expect( not input.read_more(8u) and that % input.end_offset()==8u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
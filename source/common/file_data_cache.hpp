@@ -0,0 +1,136 @@
+#pragma once
+//  ---------------------------------------------
+//  Keeps in memory some data obtained from the
+//  content of files, without keeping them open
+//  ---------------------------------------------
+//  #include "file_data_cache.hpp" // sys::file_data_cache<>
+//  ---------------------------------------------
+#include <concepts> // std::invocable
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <string_view>
+#include <memory> // std::shared_ptr
+#include <mutex> // std::mutex, std::scoped_lock
+#include <unordered_map>
+
+#include "filesystem_utilities.hpp" // fs::*
+#include "mapped_files_cache.hpp" // sys::file_stamp_t, sys::erase_least_recently_used()
+#include "bytes_hash.hpp" // MG::hash_of()
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The user reads the file and the data is reused while the file has the
+// same stamp and the read bytes the same hash: a file rewritten within
+// the time resolution with the same size is detected by its content.
+// The data can't refer to the bytes. Limited and trimmed as
+// sys::mapped_files_cache. Thread safe
+template<typename T>
+class file_data_cache final
+{
+ private:
+    struct entry_t final
+       {
+        fs::path path;
+        file_stamp_t stamp;
+        std::uint64_t hash = 0u;
+        std::shared_ptr<const T> data;
+        std::uint64_t last_use = 0u;
+       };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, entry_t> m_entries;
+    std::uint64_t m_uses_count = 0u;
+    std::size_t m_max_entries;
+
+ public:
+    static constexpr std::size_t default_max_entries = 1024u;
+
+    explicit file_data_cache(const std::size_t max_entries =default_max_entries) noexcept
+      : m_max_entries{max_entries}
+       {}
+
+    //-----------------------------------------------------------------------
+    // 'bytes' is the current content of the file, 'obtain_data(bytes)'
+    // is called when not cached or changed
+    template<std::invocable<const std::string_view> F>
+    [[nodiscard]] std::shared_ptr<const T> get(const fs::path& pth, std::string&& key, const std::string_view bytes, F&& obtain_data)
+       {
+        const file_stamp_t stamp = file_stamp_t::of(pth);
+        const std::uint64_t hash = MG::hash_of(bytes);
+           {std::scoped_lock lock(m_mutex);
+            if( const auto it=m_entries.find(key); it!=m_entries.end() and it->second.stamp==stamp and it->second.hash==hash )
+               {
+                it->second.last_use = ++m_uses_count;
+                return it->second.data;
+               }
+           }
+
+        // Not holding the lock while obtaining the data
+        auto data = std::make_shared<const T>( obtain_data(bytes) );
+        std::scoped_lock lock(m_mutex);
+        m_entries.insert_or_assign(std::move(key), entry_t{pth, stamp, hash, data, ++m_uses_count});
+        erase_least_recently_used(m_entries, m_max_entries);
+        return data;
+       }
+
+    //-----------------------------------------------------------------------
+    // Drop the entries of the modified or removed files
+    void trim()
+       {
+        std::scoped_lock lock(m_mutex);
+        std::erase_if(m_entries, [](const auto& item) noexcept { return not item.second.stamp.matches(item.second.path); });
+       }
+
+    [[nodiscard]] std::size_t size() const
+       {
+        std::scoped_lock lock(m_mutex);
+        return m_entries.size();
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_data_cache"> file_data_cache_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::file_data_cache") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file = dir.create_file("file.txt", "abc"sv);
+    sys::file_data_cache<std::string> cache;
+    int obtained_count = 0;
+    const auto first_char = [&obtained_count](const std::string_view bytes){ ++obtained_count; return std::string(bytes.substr(0,1)); };
+
+    ut::expect( ut::that % *cache.get(file.path(), "k", "abc"sv, first_char)=="a"sv );
+    ut::expect( ut::that % *cache.get(file.path(), "k", "abc"sv, first_char)=="a"sv );
+    ut::expect( ut::that % obtained_count==1 ) << "second get should be cached\n";
+
+    // Same size and time, different content
+    const auto mtime = fs::last_write_time(file.path());
+    test::write_to_file(file.path().string(), "xyz"sv);
+    fs::last_write_time(file.path(), mtime);
+    ut::expect( ut::that % *cache.get(file.path(), "k", "xyz"sv, first_char)=="x"sv );
+    ut::expect( ut::that % obtained_count==2 ) << "changed content\n";
+
+    file << "def"sv; // Changes size
+    ut::expect( ut::that % *cache.get(file.path(), "k", "xyzdef"sv, first_char)=="x"sv );
+    ut::expect( ut::that % obtained_count==3 ) << "changed file\n";
+    ut::expect( ut::that % cache.size()==1u );
+
+    fs::remove(file.path());
+    cache.trim();
+    ut::expect( ut::that % cache.size()==0u ) << "removed file should be dropped\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
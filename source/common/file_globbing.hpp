@@ -54,6 +54,25 @@ namespace MG //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
     return unglobbed_paths;
 }
 
+
+//---------------------------------------------------------------------------
+// Tells if 'file_glob(globbed_path)' would list 'file_path'
+[[nodiscard]] bool file_glob_matches(const fs::path& globbed_path, const fs::path& file_path)
+{
+    const auto normalized_dir_of = [](const fs::path& pth) -> fs::path
+       {
+        return pth.has_parent_path() ? fs::absolute(pth.parent_path()).lexically_normal() : fs::current_path();
+       };
+    if( normalized_dir_of(globbed_path)!=normalized_dir_of(file_path) )
+       {
+        return false;
+       }
+
+    const std::string globbed_fname = globbed_path.filename().string();
+    const std::string fname = file_path.filename().string();
+    return contains_wildcards(globbed_fname) ? glob_match(fname, globbed_fname, '/') : fname==globbed_fname;
+}
+
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 
@@ -112,6 +131,16 @@ ut::test("MG::file_glob()") = []
        };
    };
 
+ut::test("MG::file_glob_matches()") = []
+   {
+    const fs::path dir = fs::temp_directory_path();
+    ut::expect( MG::file_glob_matches(dir / "*.txt", dir / "a.txt") );
+    ut::expect( MG::file_glob_matches(dir / "a.txt", dir / "a.txt") );
+    ut::expect( not MG::file_glob_matches(dir / "*.txt", dir / "a.cfg") );
+    ut::expect( not MG::file_glob_matches(dir / "*.txt", dir / "sub" / "a.txt") );
+    ut::expect( not MG::file_glob_matches(dir / "a.txt", dir / "b.txt") );
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,137 @@
+#pragma once
+//  ---------------------------------------------
+//  A file whose byte ranges can be appended
+//  to another one without reading them
+//  ---------------------------------------------
+//  #include "file_range_source.hpp" // sys::file_range_source
+//  ---------------------------------------------
+#include <string_view>
+#include <cstdint> // std::uint64_t
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+#include "file_write.hpp" // sys::file_write
+#include "file_stamp.hpp" // sys::file_stamp_t
+
+#if defined(POSIX)
+  #include <fcntl.h> // open
+  #include <unistd.h> // close
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Ranges smaller than 'min_size' are written from the given bytes,
+// not worth the flush and the system call. The file is opened again
+// by path: when given the stamp of the file where the bytes come from,
+// a file modified or replaced in the meantime is not used
+class file_range_source final
+{
+ public:
+    static constexpr std::size_t min_size = 64u * 1024u;
+
+ private:
+    int m_fd = -1;
+
+ public:
+    explicit file_range_source([[maybe_unused]] const char* const pth_cstr) noexcept
+       {
+      #if defined(POSIX)
+        m_fd = ::open(pth_cstr, O_RDONLY | O_CLOEXEC); // If fails, will write the bytes
+      #endif
+       }
+
+    file_range_source(const char* const pth_cstr, [[maybe_unused]] const file_stamp_t& expected_stamp) noexcept
+      : file_range_source(pth_cstr)
+       {
+      #if defined(POSIX)
+        if( m_fd!=-1 and file_stamp_t::of_open_file(m_fd)!=expected_stamp )
+           {// Not the file of the bytes anymore
+            ::close(m_fd);
+            m_fd = -1;
+           }
+      #endif
+       }
+
+    ~file_range_source() noexcept
+       {
+      #if defined(POSIX)
+        if( m_fd!=-1 ) ::close(m_fd);
+      #endif
+       }
+
+    file_range_source(const file_range_source&) = delete; // Prevent copy
+    file_range_source& operator=(const file_range_source&) = delete;
+    file_range_source(file_range_source&&) = delete; // Prevent move
+    file_range_source& operator=(file_range_source&&) = delete;
+
+    //-----------------------------------------------------------------------
+    // 'bytes' is the range content as in the source file at 'offset'
+    void append_to(const file_write& out_file, const std::uint64_t offset, const std::string_view bytes) const
+       {
+        if( m_fd==-1 or bytes.size()<min_size or not out_file.append_file_range(m_fd, offset, bytes.size()) )
+           {
+            out_file << bytes;
+           }
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_range_source"> file_range_source_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::file_range_source") = []
+   {
+    test::TemporaryDirectory dir;
+    std::string content;
+    for( std::size_t i=0; content.size()<3u*sys::file_range_source::min_size; ++i )
+       {
+        content += std::format("line {}\n", i);
+       }
+    const auto src = dir.create_file("src.txt", content);
+    const auto out = dir.decl_file("out.txt");
+
+       {const sys::file_range_source source{ src.path().string().c_str() };
+        sys::file_write out_file{ out.path().string().c_str() };
+        out_file << "head:"sv;
+        const std::string_view content_sv{content};
+        source.append_to(out_file, 10u, content_sv.substr(10u, 2u*sys::file_range_source::min_size)); // Big
+        out_file << ":mid:"sv;
+        source.append_to(out_file, 0u, content_sv.substr(0u, 20u)); // Small
+        out_file << ":tail"sv;
+       }
+
+    const std::string_view content_sv{content};
+    const std::string expected = std::format("head:{}:mid:{}:tail", content_sv.substr(10u, 2u*sys::file_range_source::min_size), content_sv.substr(0u, 20u));
+    ut::expect( test::read_file_content(out.path().string())==expected );
+   };
+
+ut::test("sys::file_range_source of a replaced file") = []
+   {
+    test::TemporaryDirectory dir;
+    const std::string content(2u*sys::file_range_source::min_size, 'a');
+    const auto src = dir.create_file("src.txt", content);
+    const sys::file_stamp_t stamp = sys::file_stamp_t::of(src.path());
+    const auto out = dir.decl_file("out.txt");
+
+    // Replaced with another version before copying the range
+    const auto other = dir.create_file("other.txt", std::string(content.size(), 'b'));
+    fs::rename(other.path(), src.path());
+       {const sys::file_range_source source{ src.path().string().c_str(), stamp };
+        sys::file_write out_file{ out.path().string().c_str() };
+        source.append_to(out_file, 0u, content);
+       }
+    ut::expect( test::read_file_content(out.path().string())==content ) << "should write the given bytes\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,123 @@
+#pragma once
+//  ---------------------------------------------
+//  What tells if a file was modified or
+//  replaced, without reading it
+//  ---------------------------------------------
+//  #include "file_stamp.hpp" // sys::file_stamp_t
+//  ---------------------------------------------
+#include <cstdint> // std::uintmax_t
+#include <optional>
+#include <chrono> // std::chrono::*
+
+#include "filesystem_utilities.hpp" // fs::*
+#include "os-detect.hpp" // POSIX
+
+#if defined(POSIX)
+  #include <cerrno> // errno
+  #include <system_error> // std::error_code
+  #include <sys/stat.h> // ::stat, ::fstat
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Size and time, to detect a modified file without reading it,
+// and the file identity (where available) to detect a replaced one
+struct file_stamp_t final
+{
+    std::uintmax_t size = 0u;
+    fs::file_time_type mtime{};
+    std::uintmax_t device = 0u;
+    std::uintmax_t inode = 0u;
+
+    [[nodiscard]] static file_stamp_t of(const fs::path& pth)
+       {
+      #if defined(POSIX)
+        struct ::stat st{};
+        if( ::stat(pth.string().c_str(), &st)!=0 )
+           {
+            throw fs::filesystem_error("Cannot get the file status", pth, std::error_code{errno, std::generic_category()});
+           }
+        return of(st);
+      #else
+        return file_stamp_t{ fs::file_size(pth), fs::last_write_time(pth) };
+      #endif
+       }
+
+  #if defined(POSIX)
+    //-----------------------------------------------------------------------
+    // Of an already opened file, to check that is the expected one
+    [[nodiscard]] static std::optional<file_stamp_t> of_open_file(const int fd) noexcept
+       {
+        struct ::stat st{};
+        if( ::fstat(fd, &st)!=0 )
+           {
+            return std::nullopt;
+           }
+        return of(st);
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static file_stamp_t of(const struct ::stat& st) noexcept
+       {
+        using namespace std::chrono;
+        const sys_time<nanoseconds> mtime_sys{ seconds{st.st_mtim.tv_sec} + nanoseconds{st.st_mtim.tv_nsec} };
+        return file_stamp_t{ static_cast<std::uintmax_t>(st.st_size),
+                             time_point_cast<fs::file_time_type::duration>(fs::file_time_type::clock::from_sys(mtime_sys)),
+                             static_cast<std::uintmax_t>(st.st_dev),
+                             static_cast<std::uintmax_t>(st.st_ino) };
+       }
+  #endif
+
+    //-----------------------------------------------------------------------
+    // Still the stamp of the file, false also when the file is gone
+    [[nodiscard]] bool matches(const fs::path& pth) const noexcept
+       {
+        try{
+            return of(pth)==*this;
+           }
+        catch(...)
+           {
+            return false;
+           }
+       }
+
+    [[nodiscard]] bool operator==(const file_stamp_t&) const noexcept = default;
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_stamp_t"> file_stamp_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::file_stamp_t") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file = dir.create_file("file.txt", "abc"sv);
+    const sys::file_stamp_t stamp = sys::file_stamp_t::of(file.path());
+    ut::expect( ut::that % stamp.size==3u );
+    ut::expect( stamp.mtime==fs::last_write_time(file.path()) );
+    ut::expect( stamp.matches(file.path()) );
+
+    // Replaced by another file with same size and time
+    const auto other = dir.create_file("other.txt", "xyz"sv);
+    fs::last_write_time(other.path(), stamp.mtime);
+    fs::rename(other.path(), file.path());
+    ut::expect( not stamp.matches(file.path()) ) << "replaced file should not match\n";
+
+    fs::remove(file.path());
+    ut::expect( not stamp.matches(file.path()) );
+    ut::expect( ut::throws([&]{ [[maybe_unused]] const auto s = sys::file_stamp_t::of(file.path()); }) );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,221 @@
+#pragma once
+//  ---------------------------------------------
+//  Facility to write a file only if its
+//  content actually changes
+//  ---------------------------------------------
+//  #include "file_update.hpp" // sys::file_update
+//  ---------------------------------------------
+#include <cassert>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <stdexcept> // std::runtime_error
+#include <format>
+
+#include "filesystem_utilities.hpp" // fs::*, fsu::*
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "file_write.hpp" // sys::file_write
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The streamed content is compared with the existing file: as soon as a
+// byte differs, the output is diverted to a temporary file that will
+// replace the original one on commit(). An unchanged file is just read
+// and left untouched, preserving its modification time. A symlink is
+// not replaced, the file it points to is
+class file_update final
+{
+ private:
+    fs::path m_path;
+    std::optional<memory_mapped_file> m_existing_mapped;
+    std::string_view m_existing; // Content of the existing file
+    std::size_t m_matched_size = 0u; // Leading bytes equal to the existing file
+    fs::path m_temp_path;
+    std::optional<file_write> m_temp_file; // Engaged when the content differs
+    std::size_t m_buffer_size = BUFSIZ;
+    bool m_committed = false;
+
+ public:
+    explicit file_update(const fs::path& pth)
+      : m_path{ fsu::resolve_symlink(pth) }
+       {
+        if( not fsu::exists(m_path) )
+           {// Nothing to compare with
+            divert();
+           }
+        else if( not fs::is_regular_file(m_path) )
+           {
+            throw std::runtime_error{ std::format("Cannot write to file `{}`", m_path.string()) };
+           }
+        else if( fs::file_size(m_path)>0u ) // Can't map an empty file
+           {
+            m_existing_mapped.emplace( m_path.string().c_str() );
+            m_existing = m_existing_mapped->as_string_view();
+           }
+       }
+
+    ~file_update() noexcept
+       {
+        if( not m_committed and m_temp_file.has_value() )
+           {
+            m_temp_file.reset();
+            std::error_code ec;
+            fs::remove(m_temp_path, ec);
+           }
+       }
+
+    file_update(const file_update&) = delete; // Prevent copy
+    file_update& operator=(const file_update&) = delete;
+    file_update(file_update&&) = delete; // Prevent move
+    file_update& operator=(file_update&&) = delete;
+
+
+    void set_buffer_size(const std::size_t siz =BUFSIZ) noexcept
+       {
+        m_buffer_size = siz;
+        if( m_temp_file.has_value() ) m_temp_file->set_buffer_size(m_buffer_size);
+       }
+
+
+    file_update& operator<<(const char c)
+       {
+        return *this << std::string_view{&c, 1u};
+       }
+
+    file_update& operator<<(const std::string_view sv)
+       {
+        if( m_temp_file.has_value() )
+           {
+            *m_temp_file << sv;
+           }
+        else if( m_existing.substr(m_matched_size, sv.size())==sv )
+           {
+            m_matched_size += sv.size();
+           }
+        else
+           {
+            divert();
+            *m_temp_file << sv;
+           }
+        return *this;
+       }
+
+    //-----------------------------------------------------------------------
+    // Finalize the file, returns true if it was (re)written
+    bool commit()
+       {
+        assert(not m_committed);
+        m_committed = true;
+
+        if( not m_temp_file.has_value() )
+           {
+            if( m_matched_size==m_existing.size() )
+               {// Same content
+                return false;
+               }
+            divert(); // Truncated content
+           }
+
+        m_temp_file.reset(); // Close it
+        m_existing = {};
+        m_existing_mapped.reset(); // Release the original file before replacing it
+        fsu::replace_file(m_temp_path, m_path);
+        return true;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    void divert()
+       {
+        m_temp_path = fsu::get_a_sibling_temporary_path_for(m_path);
+        m_temp_file.emplace( m_temp_path.string().c_str() );
+        m_temp_file->set_buffer_size(m_buffer_size);
+        *m_temp_file << m_existing.substr(0, m_matched_size);
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::file_update"> file_update_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::file_update") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file = dir.create_file("file.txt", "123456"sv);
+
+    const auto update_with = [&file](const std::string_view content) -> bool
+       {
+        sys::file_update out{ file.path() };
+        out << content.substr(0,2) << content.substr(2);
+        return out.commit();
+       };
+
+    ut::should("not write the same content") = [&]
+       {
+        const auto time_before = fs::last_write_time(file.path());
+        ut::expect( not update_with("123456"sv) );
+        ut::expect( fs::last_write_time(file.path())==time_before );
+       };
+
+    ut::should("write a different content") = [&]
+       {
+        ut::expect( update_with("123x56"sv) );
+        ut::expect( ut::that % test::read_file_content(file.path().string())=="123x56"sv );
+       };
+
+    ut::should("write a longer content") = [&]
+       {
+        ut::expect( update_with("123x5678"sv) );
+        ut::expect( ut::that % test::read_file_content(file.path().string())=="123x5678"sv );
+       };
+
+    ut::should("write a shorter content") = [&]
+       {
+        ut::expect( update_with("123"sv) );
+        ut::expect( ut::that % test::read_file_content(file.path().string())=="123"sv );
+       };
+
+    ut::should("create a new file") = [&]
+       {
+        const fs::path new_file_path = dir.path() / "new.txt";
+           {sys::file_update out{ new_file_path };
+            out << "abc"sv << '\n';
+            ut::expect( out.commit() ); }
+        ut::expect( ut::that % test::read_file_content(new_file_path.string())=="abc\n"sv );
+       };
+
+    ut::should("write through a symlink") = [&]
+       {
+        const fs::path link_path = dir.path() / "link.txt";
+        fs::create_symlink(file.path().filename(), link_path);
+           {sys::file_update out{ link_path };
+            out << "123"sv << "456"sv;
+            ut::expect( out.commit() ); }
+        ut::expect( fs::is_symlink(link_path) ) << "link should be kept\n";
+        ut::expect( ut::that % test::read_file_content(file.path().string())=="123456"sv );
+        fs::remove(link_path);
+        ut::expect( update_with("123"sv) );
+       };
+
+    ut::should("leave the file untouched if not committed") = [&]
+       {
+           {sys::file_update out{ file.path() };
+            out << "zzz"sv; }
+        ut::expect( ut::that % test::read_file_content(file.path().string())=="123"sv );
+        ut::expect( test::have_same_elements(fsu::list_filenames_in_dir(dir.path()), {std::string{"file.txt"}, std::string{"new.txt"}}) ) << "temporary file should be removed\n";
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -8,9 +8,16 @@
 #include <cstdio> // std::fopen, ::fopen_s (Microsoft)
 #include <stdexcept> // std::runtime_error
 #include <format>
+#include <cstdint> // std::uint64_t
 
 #include "os-detect.hpp" // MS_WINDOWS, POSIX
 
+#if defined(__linux__)
+  #include <cerrno> // errno
+  #include <cstring> // std::strerror
+  #include <unistd.h> // copy_file_range
+#endif
+
 
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -24,6 +31,7 @@ class file_write final
 {
  private:
     std::FILE* m_fstream = nullptr;
+    bool m_owned = true; // Otherwise not closed
 
  public:
     enum flags_t : char
@@ -45,7 +53,8 @@ class file_write final
        {
         if( m_fstream )
            {
-            std::fclose(m_fstream);
+            if( m_owned ) std::fclose(m_fstream);
+            else std::fflush(m_fstream);
            }
        }
 
@@ -54,6 +63,7 @@ class file_write final
 
     file_write(file_write&& other) noexcept
       : m_fstream(other.m_fstream)
+      , m_owned(other.m_owned)
        {
         other.m_fstream = nullptr;
        }
@@ -61,9 +71,26 @@ class file_write final
     file_write& operator=(file_write&& other) noexcept
        {
         std::swap(m_fstream, other.m_fstream);
+        std::swap(m_owned, other.m_owned);
         return *this;
        }
 
+    //-----------------------------------------------------------------------
+    // Writing to an already open stream (ex. stdout), that won't be closed
+    [[nodiscard]] static file_write to_stream(std::FILE* const stream) noexcept
+       {
+        return file_write{stream};
+       }
+
+ private:
+    explicit file_write(std::FILE* const stream) noexcept
+      : m_fstream(stream)
+      , m_owned(false)
+       {
+        assert(m_fstream!=nullptr);
+       }
+
+ public:
 
     void set_buffer_size(const std::size_t siz =BUFSIZ) noexcept
        {
@@ -88,6 +115,49 @@ class file_write final
         return *this;
        }
 
+    //-----------------------------------------------------------------------
+    // Append a range of another file copying it kernel side, without
+    // passing through the buffers. Returns false if not possible,
+    // and in that case nothing was written
+    [[nodiscard]] bool append_file_range([[maybe_unused]] const int src_fd, [[maybe_unused]] std::uint64_t offset, [[maybe_unused]] std::size_t size) const
+       {
+        assert(m_fstream!=nullptr);
+      #if defined(__linux__)
+        if( std::fflush(m_fstream)!=0 )
+           {
+            return false;
+           }
+        const int out_fd = ::fileno(m_fstream);
+        bool something_copied = false;
+        auto off_in = static_cast<::off64_t>(offset);
+        while( size>0u )
+           {
+            const ::ssize_t n = ::copy_file_range(src_fd, &off_in, out_fd, nullptr, size, 0u);
+            if( n>0 )
+               {
+                size -= static_cast<std::size_t>(n);
+                something_copied = true;
+               }
+            else if( n==0 )
+               {
+                throw std::runtime_error{"Source file shrunk while copying"};
+               }
+            else if( errno!=EINTR )
+               {
+                if( not something_copied )
+                   {// Not supported here (different filesystems, old kernel...)
+                    return false;
+                   }
+                throw std::runtime_error{ std::format("Cannot copy file range ({})", std::strerror(errno)) };
+               }
+           }
+        std::fseek(m_fstream, 0, SEEK_END); // The stream must know the new position
+        return true;
+      #else
+        return false;
+      #endif
+       }
+
  private:
     [[nodiscard]] static inline std::FILE* file_open( const char* const filename, const char* const mode ) noexcept
        {
@@ -0,0 +1,225 @@
+#pragma once
+//  ---------------------------------------------
+//  Get notified of the files written
+//  in some directories
+//  ---------------------------------------------
+//  #include "files_watcher.hpp" // sys::files_watcher
+//  ---------------------------------------------
+#include <vector>
+#include <chrono>
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <algorithm> // std::ranges::sort, std::ranges::unique
+#include <filesystem> // std::filesystem
+namespace fs = std::filesystem;
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+
+#if defined(__linux__)
+  #include <unordered_map>
+  #include <cstring> // std::strerror
+  #include <cerrno> // errno
+  #include <sys/inotify.h> // inotify_init1, inotify_add_watch
+  #include <poll.h> // poll
+  #include <unistd.h> // read, close
+#else
+  #include <map>
+  #include <thread> // std::this_thread::sleep_for
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Reports the files completely written or moved into the watched
+// directories. Uses inotify on linux, elsewhere scans the directories
+class files_watcher final
+{
+ public:
+    using duration_t = std::chrono::milliseconds;
+    static constexpr duration_t settle_time{100}; // Collecting events of a same save
+
+ private:
+  #if defined(__linux__)
+    int m_fd = -1;
+    std::unordered_map<int, fs::path> m_dirs; // By watch descriptor
+  #else
+    static constexpr duration_t scan_period{500};
+    using dir_snapshot_t = std::map<fs::path, fs::file_time_type>;
+    std::map<fs::path, dir_snapshot_t> m_dirs;
+  #endif
+
+ public:
+    files_watcher()
+       {
+      #if defined(__linux__)
+        m_fd = ::inotify_init1(IN_CLOEXEC);
+        if( m_fd==-1 )
+           {
+            throw std::runtime_error{ std::format("Cannot initialize inotify ({})", std::strerror(errno)) };
+           }
+      #endif
+       }
+
+    ~files_watcher() noexcept
+       {
+      #if defined(__linux__)
+        if( m_fd!=-1 ) ::close(m_fd);
+      #endif
+       }
+
+    files_watcher(const files_watcher&) = delete; // Prevent copy
+    files_watcher& operator=(const files_watcher&) = delete;
+    files_watcher(files_watcher&&) = delete; // Prevent move
+    files_watcher& operator=(files_watcher&&) = delete;
+
+    //-----------------------------------------------------------------------
+    void add_dir(const fs::path& dir)
+       {
+        const fs::path dir_path = dir.empty() ? fs::current_path() : fs::absolute(dir).lexically_normal();
+      #if defined(__linux__)
+        const int wd = ::inotify_add_watch(m_fd, dir_path.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if( wd==-1 )
+           {
+            throw std::runtime_error{ std::format("Cannot watch {} ({})", dir_path.string(), std::strerror(errno)) };
+           }
+        m_dirs.insert_or_assign(wd, dir_path);
+      #else
+        m_dirs.insert_or_assign(dir_path, take_snapshot_of(dir_path));
+      #endif
+       }
+
+    //-----------------------------------------------------------------------
+    // Blocks until some files are written in the watched directories
+    // or the timeout expires, returns the (sorted) paths of the files
+    [[nodiscard]] std::vector<fs::path> wait_written_files(const duration_t timeout)
+       {
+        std::vector<fs::path> files;
+      #if defined(__linux__)
+        if( wait_events(timeout) )
+           {
+            do {
+                read_events(files);
+               }
+            while( wait_events(settle_time) );
+           }
+      #else
+        const auto start = std::chrono::steady_clock::now();
+        while( files.empty() and std::chrono::steady_clock::now()-start<timeout )
+           {
+            std::this_thread::sleep_for( std::min<duration_t>(scan_period, timeout) );
+            for( auto& [dir_path, snapshot] : m_dirs )
+               {
+                dir_snapshot_t new_snapshot = take_snapshot_of(dir_path);
+                for( const auto& [file_path, time] : new_snapshot )
+                   {
+                    if( const auto it=snapshot.find(file_path); it==snapshot.end() or it->second!=time )
+                       {
+                        files.push_back(file_path);
+                       }
+                   }
+                snapshot = std::move(new_snapshot);
+               }
+           }
+      #endif
+        std::ranges::sort(files);
+        const auto [new_end, end] = std::ranges::unique(files);
+        files.erase(new_end, end);
+        return files;
+       }
+
+ private:
+  #if defined(__linux__)
+    //-----------------------------------------------------------------------
+    [[nodiscard]] bool wait_events(const duration_t timeout) const
+       {
+        ::pollfd pfd{ .fd=m_fd, .events=POLLIN, .revents=0 };
+        const int ret = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+        if( ret==-1 and errno!=EINTR )
+           {
+            throw std::runtime_error{ std::format("Cannot poll inotify ({})", std::strerror(errno)) };
+           }
+        return ret>0;
+       }
+
+    //-----------------------------------------------------------------------
+    void read_events(std::vector<fs::path>& files) const
+       {
+        alignas(::inotify_event) char buf[4096];
+        const ::ssize_t len = ::read(m_fd, buf, sizeof(buf));
+        if( len<=0 )
+           {
+            return;
+           }
+        for( ::ssize_t i=0; i<len; )
+           {
+            const auto* const event = reinterpret_cast<const ::inotify_event*>(buf + i);
+            if( event->len>0u and not (event->mask & IN_ISDIR) )
+               {
+                if( const auto it=m_dirs.find(event->wd); it!=m_dirs.end() )
+                   {
+                    files.push_back( it->second / event->name );
+                   }
+               }
+            i += static_cast<::ssize_t>(sizeof(::inotify_event) + event->len);
+           }
+       }
+  #else
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static dir_snapshot_t take_snapshot_of(const fs::path& dir_path)
+       {
+        dir_snapshot_t snapshot;
+        std::error_code ec;
+        for( const fs::directory_entry& ientry : fs::directory_iterator(dir_path, ec) )
+           {
+            if( ientry.is_regular_file(ec) )
+               {
+                snapshot.insert_or_assign(ientry.path(), ientry.last_write_time(ec));
+               }
+           }
+        return snapshot;
+       }
+  #endif
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::files_watcher"> files_watcher_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::files_watcher") = []
+   {
+    test::TemporaryDirectory dir;
+    sys::files_watcher watcher;
+    watcher.add_dir(dir.path());
+
+    ut::should("time out when nothing happens") = [&]
+       {
+        ut::expect( watcher.wait_written_files(std::chrono::milliseconds{10}).empty() );
+       };
+
+    ut::should("report a written file") = [&]
+       {
+        std::jthread writer([&dir]
+           {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            [[maybe_unused]] const auto file = dir.create_file("file.txt", "abc"sv);
+           });
+        const auto files = watcher.wait_written_files(std::chrono::seconds{5});
+        ut::expect( ut::that % files.size()==1u );
+        ut::expect( not files.empty() and files.front().filename()=="file.txt" );
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
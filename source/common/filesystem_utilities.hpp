@@ -5,6 +5,9 @@
 //  ---------------------------------------------
 #include <vector>
 #include <format>
+#include <atomic>
+#include <random> // std::random_device
+#include <chrono> // std::chrono::steady_clock
 #include <filesystem> // std::filesystem
 namespace fs = std::filesystem;
 
@@ -48,6 +51,46 @@ namespace fsu //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
     return temp_path;
 }
 
+//---------------------------------------------------------------------------
+// A hidden temporary path in the same directory, so that
+// a rename on the target file is possible. Unique also among
+// processes writing the same target
+[[nodiscard]] fs::path get_a_sibling_temporary_path_for(const fs::path& file)
+{
+    static std::atomic<unsigned int> counter{0u};
+    return file.parent_path() / std::format(".~{}.{:x}.{:x}.{}.tmp", file.filename().string(), std::random_device{}(), std::chrono::steady_clock::now().time_since_epoch().count(), ++counter);
+}
+
+//---------------------------------------------------------------------------
+// The file a symlink points to (following the chain), to replace that
+// instead of the link; other paths are returned as they are
+[[nodiscard]] fs::path resolve_symlink(const fs::path& pth)
+{
+    std::error_code ec;
+    return fs::is_symlink(pth, ec) ? fs::weakly_canonical(pth) : pth;
+}
+
+//---------------------------------------------------------------------------
+// Replace 'target' with 'new_file' in a single step, so that who reads
+// 'target' never sees an incomplete content. The permissions of the
+// replaced file are preserved. If a rename is not possible (different
+// filesystems) falls back to a non atomic copy
+void replace_file(const fs::path& new_file, const fs::path& target)
+{
+    std::error_code ec;
+    if( const fs::file_status target_status = fs::status(target, ec); not ec and fs::is_regular_file(target_status) )
+       {
+        fs::permissions(new_file, target_status.permissions(), ec);
+       }
+
+    fs::rename(new_file, target, ec);
+    if( ec )
+       {
+        fs::copy_file(new_file, target, fs::copy_options::overwrite_existing);
+        fs::remove(new_file, ec);
+       }
+}
+
 //---------------------------------------------------------------------------
 [[maybe_unused]] fs::path backup_file(const fs::path& file_to_backup)
 {
@@ -183,6 +226,38 @@ class CurrentPathLocalChanger final
 static ut::suite<"filesystem_utilities"> filesystem_utilities_tests = []
 {////////////////////////////////////////////////////////////////////////////
 
+ut::test("fsu::replace_file()") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto target = dir.create_file("target.txt", "old"sv);
+    const auto new_file = dir.create_file(fsu::get_a_sibling_temporary_path_for(target.path()).filename().string(), "new"sv);
+    fsu::replace_file(new_file.path(), target.path());
+    ut::expect( not fs::exists(new_file.path()) );
+    ut::expect( ut::that % test::read_file_content(target.path().string())=="new"sv );
+   };
+
+ut::test("fsu::resolve_symlink()") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto target = dir.create_file("target.txt", "abc"sv);
+    fs::create_directory(dir.path() / "sub");
+    fs::create_symlink("../target.txt", dir.path() / "sub" / "link.txt");
+    fs::create_symlink("sub/link.txt", dir.path() / "link-to-link.txt");
+    ut::expect( fsu::resolve_symlink(dir.path() / "link-to-link.txt")==fs::canonical(target.path()) );
+    ut::expect( fsu::resolve_symlink(target.path())==target.path() );
+    ut::expect( fsu::resolve_symlink(dir.path() / "none.txt")==dir.path() / "none.txt" );
+   };
+
+ut::test("fsu::get_a_sibling_temporary_path_for()") = []
+   {
+    const fs::path target{"dir/target.txt"};
+    const fs::path temp1 = fsu::get_a_sibling_temporary_path_for(target);
+    const fs::path temp2 = fsu::get_a_sibling_temporary_path_for(target);
+    ut::expect( temp1.parent_path()==target.parent_path() and temp2.parent_path()==target.parent_path() );
+    ut::expect( temp1.filename().string().starts_with(".~target.txt."sv) and temp1.filename().string().ends_with(".tmp"sv) );
+    ut::expect( temp1!=temp2 ) << "should not be shared by concurrent writers\n";
+   };
+
 ut::test("fsu::list_filenames_in_dir()") = []
    {
     test::TemporaryDirectory dir;
@@ -0,0 +1,290 @@
+#pragma once
+//  ---------------------------------------------
+//  Local (unix domain) stream sockets
+//  ---------------------------------------------
+//  #include "local_socket.hpp" // sys::local_socket_server, sys::connect_to_local_socket()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <utility> // std::exchange
+#include <optional>
+#include <chrono> // std::chrono::*
+#include <filesystem> // std::filesystem
+namespace fs = std::filesystem;
+
+#include "os-detect.hpp" // MS_WINDOWS, POSIX
+
+#if defined(POSIX)
+  #include <cstring> // std::strerror
+  #include <cerrno> // errno
+  #include <sys/socket.h> // socket, bind, listen, accept, connect
+  #include <sys/un.h> // sockaddr_un
+  #include <poll.h> // poll
+  #include <unistd.h> // read, write, close
+#endif
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// A message is all the bytes written before shutting down the writing side
+class local_socket_connection final
+{
+ private:
+    int m_fd = -1;
+
+ public:
+    explicit local_socket_connection(const int fd) noexcept
+      : m_fd{fd}
+       {}
+
+    ~local_socket_connection() noexcept
+       {
+      #if defined(POSIX)
+        if( m_fd!=-1 ) ::close(m_fd);
+      #endif
+       }
+
+    local_socket_connection(const local_socket_connection&) = delete; // Prevent copy
+    local_socket_connection& operator=(const local_socket_connection&) = delete;
+
+    local_socket_connection(local_socket_connection&& other) noexcept
+      : m_fd{ std::exchange(other.m_fd, -1) }
+       {}
+    local_socket_connection& operator=(local_socket_connection&&) = delete;
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::string receive_message() const
+       {
+        return receive_message_before(std::nullopt);
+       }
+
+    //-----------------------------------------------------------------------
+    // Throws if the whole message doesn't arrive in time
+    [[nodiscard]] std::string receive_message(const std::chrono::milliseconds timeout) const
+       {
+        return receive_message_before(std::chrono::steady_clock::now() + timeout);
+       }
+
+    //-----------------------------------------------------------------------
+    void send_message(std::string_view msg) const
+       {
+      #if defined(POSIX)
+        while( not msg.empty() )
+           {
+            const ::ssize_t n = ::send(m_fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+            if( n>=0 )
+               {
+                msg.remove_prefix(static_cast<std::size_t>(n));
+               }
+            else if( errno!=EINTR )
+               {
+                throw std::runtime_error{ std::format("Cannot write to socket ({})", std::strerror(errno)) };
+               }
+           }
+        ::shutdown(m_fd, SHUT_WR);
+      #endif
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::string receive_message_before(const std::optional<std::chrono::steady_clock::time_point> deadline) const
+       {
+        std::string msg;
+      #if defined(POSIX)
+        char buf[4096];
+        while( true )
+           {
+            if( deadline.has_value() )
+               {
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline.value() - std::chrono::steady_clock::now());
+                ::pollfd pfd{ .fd=m_fd, .events=POLLIN, .revents=0 };
+                const int ready = remaining.count()>0 ? ::poll(&pfd, 1, static_cast<int>(remaining.count())) : 0;
+                if( ready==0 )
+                   {
+                    throw std::runtime_error{"Timed out reading from socket"};
+                   }
+                else if( ready==-1 )
+                   {
+                    if( errno==EINTR ) continue;
+                    throw std::runtime_error{ std::format("Cannot read from socket ({})", std::strerror(errno)) };
+                   }
+               }
+            const ::ssize_t n = ::read(m_fd, buf, sizeof(buf));
+            if( n>0 )
+               {
+                msg.append(buf, static_cast<std::size_t>(n));
+               }
+            else if( n==0 )
+               {
+                break;
+               }
+            else if( errno!=EINTR )
+               {
+                throw std::runtime_error{ std::format("Cannot read from socket ({})", std::strerror(errno)) };
+               }
+           }
+      #endif
+        return msg;
+       }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+class local_socket_server final
+{
+ private:
+    fs::path m_path;
+    int m_fd = -1;
+
+ public:
+    explicit local_socket_server(fs::path pth)
+      : m_path{ std::move(pth) }
+       {
+      #if defined(POSIX)
+        const ::sockaddr_un addr = address_of(m_path);
+        if( fs::is_socket(m_path) )
+           {// Left by a previous run
+            fs::remove(m_path);
+           }
+
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if( m_fd==-1 )
+           {
+            throw std::runtime_error{ std::format("Cannot create socket ({})", std::strerror(errno)) };
+           }
+        if( ::bind(m_fd, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr))==-1 or ::listen(m_fd, 16)==-1 )
+           {
+            const std::string msg{ std::strerror(errno) };
+            ::close(m_fd);
+            throw std::runtime_error{ std::format("Cannot listen on {} ({})", m_path.string(), msg) };
+           }
+      #else
+        throw std::runtime_error{"Local sockets not supported on this system"};
+      #endif
+       }
+
+    ~local_socket_server() noexcept
+       {
+      #if defined(POSIX)
+        if( m_fd!=-1 )
+           {
+            ::close(m_fd);
+            std::error_code ec;
+            fs::remove(m_path, ec);
+           }
+      #endif
+       }
+
+    local_socket_server(const local_socket_server&) = delete; // Prevent copy
+    local_socket_server& operator=(const local_socket_server&) = delete;
+    local_socket_server(local_socket_server&&) = delete; // Prevent move
+    local_socket_server& operator=(local_socket_server&&) = delete;
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] local_socket_connection accept_connection() const
+       {
+      #if defined(POSIX)
+        while( true )
+           {
+            const int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if( fd!=-1 )
+               {
+                return local_socket_connection{fd};
+               }
+            else if( errno!=EINTR and errno!=ECONNABORTED )
+               {
+                throw std::runtime_error{ std::format("Cannot accept connections ({})", std::strerror(errno)) };
+               }
+           }
+      #else
+        return local_socket_connection{-1};
+      #endif
+       }
+
+  #if defined(POSIX)
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static ::sockaddr_un address_of(const fs::path& pth)
+       {
+        ::sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        const std::string pth_str{ pth.string() };
+        if( pth_str.empty() or pth_str.size()>=sizeof(addr.sun_path) )
+           {
+            throw std::runtime_error{ std::format("Invalid socket path: {}", pth_str) };
+           }
+        pth_str.copy(addr.sun_path, pth_str.size());
+        return addr;
+       }
+  #endif
+};
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] local_socket_connection connect_to_local_socket(const fs::path& pth)
+{
+  #if defined(POSIX)
+    const ::sockaddr_un addr = local_socket_server::address_of(pth);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if( fd==-1 )
+       {
+        throw std::runtime_error{ std::format("Cannot create socket ({})", std::strerror(errno)) };
+       }
+    local_socket_connection connection{fd};
+    if( ::connect(fd, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr))==-1 )
+       {
+        throw std::runtime_error{ std::format("Cannot connect to {} ({})", pth.string(), std::strerror(errno)) };
+       }
+    return connection;
+  #else
+    throw std::runtime_error{ std::format("Cannot connect to {} (local sockets not supported)", pth.string()) };
+  #endif
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::local_socket"> local_socket_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::local_socket_server") = []
+   {
+    test::TemporaryDirectory dir;
+    const fs::path socket_path = dir.path() / "test.sock";
+    const sys::local_socket_server server{ socket_path };
+
+    std::jthread echo_server([&server]
+       {
+        const auto connection = server.accept_connection();
+        connection.send_message( std::format("echo: {}", connection.receive_message()) );
+       });
+
+    const auto connection = sys::connect_to_local_socket(socket_path);
+    connection.send_message("hello"sv);
+    ut::expect( ut::that % connection.receive_message()=="echo: hello"sv );
+   };
+
+ut::test("sys::local_socket_connection receive timeout") = []
+   {
+    test::TemporaryDirectory dir;
+    const fs::path socket_path = dir.path() / "test.sock";
+    const sys::local_socket_server server{ socket_path };
+
+    const auto silent_client = sys::connect_to_local_socket(socket_path); // Never ends its message
+    const auto connection = server.accept_connection();
+    ut::expect( ut::throws([&connection]{ [[maybe_unused]] const auto msg = connection.receive_message(std::chrono::milliseconds{50}); }) );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
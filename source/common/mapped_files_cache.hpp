@@ -0,0 +1,186 @@
+#pragma once
+//  ---------------------------------------------
+//  Keeps in memory the mapped files along with
+//  some data obtained from their content
+//  ---------------------------------------------
+//  #include "mapped_files_cache.hpp" // sys::mapped_files_cache<>
+//  ---------------------------------------------
+#include <concepts> // std::invocable
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <memory> // std::shared_ptr
+#include <mutex> // std::mutex, std::scoped_lock
+#include <unordered_map>
+#include <algorithm> // std::ranges::min_element
+
+#include "filesystem_utilities.hpp" // fs::*
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "file_stamp.hpp" // sys::file_stamp_t
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+// Erase the least recently used items of a map of entries having
+// a 'last_use' member, so that the map has at most 'max_size' items
+template<typename M>
+void erase_least_recently_used(M& entries, const std::size_t max_size)
+{
+    while( entries.size()>max_size )
+       {
+        entries.erase( std::ranges::min_element(entries, {}, [](const auto& item) noexcept { return item.second.last_use; }) );
+       }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The data is obtained from the file content, that stays mapped
+// so the data can refer to it (string_views). An entry is renewed
+// when its file changes size or time; the least recently used are
+// dropped beyond a maximum number, trim() drops the outdated ones.
+// Thread safe
+template<typename T>
+class mapped_files_cache final
+{
+ public:
+    class entry_t final
+       {
+        private:
+            file_stamp_t m_stamp;
+            memory_mapped_file m_mapped;
+            T m_data;
+
+        public:
+            template<std::invocable<const std::string_view> F>
+            entry_t(const fs::path& pth, const file_stamp_t& stamp, F&& obtain_data)
+              : m_stamp{ stamp }
+              , m_mapped{ pth.string().c_str() }
+              , m_data{ obtain_data(m_mapped.as_string_view()) }
+               {}
+
+            [[nodiscard]] const file_stamp_t& stamp() const noexcept { return m_stamp; }
+            [[nodiscard]] std::string_view bytes() const noexcept { return m_mapped.as_string_view(); }
+            [[nodiscard]] const T& data() const noexcept { return m_data; }
+       };
+
+ private:
+    struct slot_t final
+       {
+        fs::path path;
+        std::shared_ptr<const entry_t> entry;
+        std::uint64_t last_use = 0u;
+       };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, slot_t> m_entries;
+    std::uint64_t m_uses_count = 0u;
+    std::size_t m_max_entries;
+
+ public:
+    static constexpr std::size_t default_max_entries = 1024u;
+
+    explicit mapped_files_cache(const std::size_t max_entries =default_max_entries) noexcept
+      : m_max_entries{max_entries}
+       {}
+
+    //-----------------------------------------------------------------------
+    // The key should contain whatever else affects the data, besides the
+    // file content; 'obtain_data(bytes)' is called when not cached
+    template<std::invocable<const std::string_view> F>
+    [[nodiscard]] std::shared_ptr<const entry_t> get(const fs::path& pth, std::string&& key, F&& obtain_data)
+       {
+        const file_stamp_t stamp = file_stamp_t::of(pth);
+           {std::scoped_lock lock(m_mutex);
+            if( const auto it=m_entries.find(key); it!=m_entries.end() and it->second.entry->stamp()==stamp )
+               {
+                it->second.last_use = ++m_uses_count;
+                return it->second.entry;
+               }
+           }
+
+        // Not holding the lock while obtaining the data
+        auto entry = std::make_shared<const entry_t>(pth, stamp, std::forward<F>(obtain_data));
+        std::scoped_lock lock(m_mutex);
+        m_entries.insert_or_assign(std::move(key), slot_t{pth, entry, ++m_uses_count});
+        erase_least_recently_used(m_entries, m_max_entries);
+        return entry;
+       }
+
+    //-----------------------------------------------------------------------
+    // Drop the entries of the modified or removed files
+    void trim()
+       {
+        std::scoped_lock lock(m_mutex);
+        std::erase_if(m_entries, [](const auto& item) noexcept { return not item.second.entry->stamp().matches(item.second.path); });
+       }
+
+    [[nodiscard]] std::size_t size() const
+       {
+        std::scoped_lock lock(m_mutex);
+        return m_entries.size();
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::mapped_files_cache"> mapped_files_cache_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::mapped_files_cache") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file = dir.create_file("file.txt", "abc"sv);
+    sys::mapped_files_cache<std::string_view> cache;
+    int obtained_count = 0;
+    const auto first_char = [&obtained_count](const std::string_view bytes){ ++obtained_count; return bytes.substr(0,1); };
+
+    ut::expect( ut::that % cache.get(file.path(), "k", first_char)->data()=="a"sv );
+    ut::expect( ut::that % cache.get(file.path(), "k", first_char)->data()=="a"sv );
+    ut::expect( ut::that % obtained_count==1 ) << "second get should be cached\n";
+
+    ut::expect( ut::that % cache.get(file.path(), "k2", first_char)->bytes()=="abc"sv );
+    ut::expect( ut::that % obtained_count==2 ) << "different key\n";
+
+    file << "def"sv; // Changes size
+    ut::expect( ut::that % cache.get(file.path(), "k", first_char)->bytes()=="abcdef"sv );
+    ut::expect( ut::that % obtained_count==3 ) << "changed file\n";
+    ut::expect( ut::that % cache.size()==2u );
+
+    const auto other_file = dir.create_file("other.txt", "xyz"sv);
+    ut::expect( ut::that % cache.get(other_file.path(), "o", first_char)->data()=="x"sv );
+    ut::expect( ut::that % cache.size()==3u );
+    fs::remove(other_file.path());
+    cache.trim();
+    ut::expect( ut::that % cache.size()==1u ) << "outdated k2 and removed file should be dropped\n";
+   };
+
+ut::test("sys::mapped_files_cache limit") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file = dir.create_file("file.txt", "abc"sv);
+    sys::mapped_files_cache<std::string_view> cache(2u);
+    int obtained_count = 0;
+    const auto first_char = [&obtained_count](const std::string_view bytes){ ++obtained_count; return bytes.substr(0,1); };
+
+    [[maybe_unused]] auto e = cache.get(file.path(), "k1", first_char);
+    e = cache.get(file.path(), "k2", first_char);
+    e = cache.get(file.path(), "k1", first_char); // Now k2 is the least recently used
+    e = cache.get(file.path(), "k3", first_char);
+    ut::expect( ut::that % cache.size()==2u );
+    ut::expect( ut::that % obtained_count==3 );
+    e = cache.get(file.path(), "k1", first_char);
+    ut::expect( ut::that % obtained_count==3 ) << "k1 should be kept\n";
+    e = cache.get(file.path(), "k2", first_char);
+    ut::expect( ut::that % obtained_count==4 ) << "k2 should be dropped\n";
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
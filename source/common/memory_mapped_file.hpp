@@ -15,6 +15,7 @@
   #include <fcntl.h> // open
   #include <sys/stat.h> // fstat
   #include <sys/mman.h> // mmap, munmap
+  #include <unistd.h> // close
 #endif
 
 
@@ -67,11 +68,13 @@ class memory_mapped_file final
         struct stat sbuf {};
         if( fstat(fd, &sbuf)==-1 )
            {
+            close(fd);
             throw std::runtime_error{"Cannot fstat file size"};
            }
         m_bufsiz = static_cast<std::size_t>(sbuf.st_size);
 
         m_buf = static_cast<const char*>(mmap(nullptr, m_bufsiz, PROT_READ, MAP_PRIVATE, fd, 0U));
+        close(fd); // The mapping keeps its own reference to the file
         if( m_buf==MAP_FAILED )
            {
             m_buf = nullptr;
@@ -119,6 +122,22 @@ class memory_mapped_file final
     memory_mapped_file& operator=(memory_mapped_file&& other) = delete;
 
     [[nodiscard]] std::string_view as_string_view() const noexcept { return std::string_view{m_buf, m_bufsiz}; }
+
+    //-----------------------------------------------------------------------
+    // Bring the content in memory, to not wait page faults later
+    void prefetch() const noexcept
+       {
+        if( not m_buf ) return;
+      #if defined(POSIX)
+        /* const int ret = */ madvise(static_cast<void*>(const_cast<char*>(m_buf)), m_bufsiz, MADV_WILLNEED);
+      #endif
+        char acc = 0;
+        for( std::size_t i=0; i<m_bufsiz; i+=4096u )
+           {// Touch each page
+            acc ^= m_buf[i];
+           }
+        [[maybe_unused]] volatile char sink = acc;
+       }
 };
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
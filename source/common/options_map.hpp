@@ -121,6 +121,24 @@ class options_map final
         return def;
        }
 
+    //-----------------------------------------------------------------------
+    // Back to the "key1:val1,key2" form
+    [[nodiscard]] std::string to_string() const
+       {
+        std::string s;
+        for( const auto& [key, val] : m_map )
+           {
+            if( not s.empty() ) s += ',';
+            s += key;
+            if( val.has_value() )
+               {
+                s += ':';
+                s += val.value();
+               }
+           }
+        return s;
+       }
+
     //-----------------------------------------------------------------------
     [[nodiscard]] container_type::const_iterator begin() const noexcept { return m_map.begin(); }
     [[nodiscard]] container_type::const_iterator end() const noexcept { return m_map.end(); }
@@ -137,28 +155,7 @@ class options_map final
 //---------------------------------------------------------------------------
 [[nodiscard]] std::string to_string(const MG::options_map& kv)
    {
-    std::string s;
-    auto it = kv.begin();
-    if( it!=kv.end() )
-       {
-        s += it->first;
-        if( it->second.has_value() )
-           {
-            s += ':';
-            s += it->second.value();
-           }
-        while( ++it!=kv.end() )
-           {
-            s += ',';
-            s += it->first;
-            if( it->second.has_value() )
-               {
-                s += ':';
-                s += it->second.value();
-               }
-           }
-       }
-    return s;
+    return kv.to_string();
    }
 
 /////////////////////////////////////////////////////////////////////////////
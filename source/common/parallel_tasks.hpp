@@ -0,0 +1,154 @@
+#pragma once
+//  ---------------------------------------------
+//  Execute independent indexed tasks
+//  using a bunch of threads
+//  ---------------------------------------------
+//  #include "parallel_tasks.hpp" // MG::run_in_parallel()
+//  ---------------------------------------------
+#include <concepts> // std::invocable
+#include <vector>
+#include <span>
+#include <thread> // std::jthread, std::thread::hardware_concurrency()
+#include <atomic> // std::atomic
+#include <exception> // std::exception_ptr, std::current_exception()
+#include <algorithm> // std::min
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+//---------------------------------------------------------------------------
+[[nodiscard]] inline unsigned int get_hardware_threads_count() noexcept
+{
+    const unsigned int n = std::thread::hardware_concurrency();
+    return n>0u ? n : 1u;
+}
+
+
+//---------------------------------------------------------------------------
+// Calls task(idx) for each idx in the given order using up to 'threads_count'
+// threads. The workers draw from a shared cursor, so an idle thread always
+// takes the next pending task: put the heaviest tasks first to balance the
+// load. When a task throws, no further tasks are started and, once the
+// running ones are done, the exception of the lowest index is rethrown
+template<std::invocable<const std::size_t> F>
+void run_in_parallel(const std::span<const std::size_t> order, const unsigned int threads_count, F&& task)
+{
+    if( threads_count<=1u or order.size()<=1u )
+       {
+        for( const std::size_t idx : order )
+           {
+            task(idx);
+           }
+        return;
+       }
+
+    std::atomic<std::size_t> next_pos{0u};
+    std::atomic<bool> aborted{false};
+    std::vector<std::exception_ptr> errors(order.size()); // Indexed by position in 'order'
+
+    const auto worker = [&]() noexcept
+       {
+        std::size_t pos;
+        while( not aborted.load(std::memory_order_relaxed) and
+               (pos = next_pos.fetch_add(1u, std::memory_order_relaxed)) < order.size() )
+           {
+            try{
+                task( order[pos] );
+               }
+            catch(...)
+               {
+                errors[pos] = std::current_exception();
+                aborted.store(true, std::memory_order_relaxed);
+               }
+           }
+       };
+
+       {std::vector<std::jthread> workers;
+        const std::size_t workers_count = std::min<std::size_t>(threads_count, order.size());
+        workers.reserve(workers_count);
+        for( std::size_t i=0; i<workers_count; ++i )
+           {
+            workers.emplace_back(worker);
+           }
+       } // Join all
+
+    const std::exception_ptr* first_error = nullptr;
+    std::size_t first_error_idx = 0u;
+    for( std::size_t pos=0; pos<errors.size(); ++pos )
+       {
+        if( errors[pos] and (not first_error or order[pos]<first_error_idx) )
+           {
+            first_error = &errors[pos];
+            first_error_idx = order[pos];
+           }
+       }
+    if( first_error )
+       {
+        std::rethrow_exception(*first_error);
+       }
+}
+
+//---------------------------------------------------------------------------
+// Calls task(idx) for idx in [0,count)
+template<std::invocable<const std::size_t> F>
+void run_in_parallel(const std::size_t count, const unsigned int threads_count, F&& task)
+{
+    std::vector<std::size_t> order(count);
+    for( std::size_t i=0; i<count; ++i ) order[i] = i;
+    run_in_parallel(order, threads_count, std::forward<F>(task));
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <stdexcept> // std::runtime_error
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"parallel_tasks"> parallel_tasks_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::run_in_parallel()") = []
+   {
+    ut::should("execute all tasks") = []
+       {
+        std::vector<int> results(100, 0);
+        MG::run_in_parallel(results.size(), 4u, [&results](const std::size_t idx) { results[idx] = static_cast<int>(idx); });
+        for( std::size_t i=0; i<results.size(); ++i )
+           {
+            ut::expect( ut::that % results[i]==static_cast<int>(i) );
+           }
+       };
+
+    ut::should("respect the given order with a single thread") = []
+       {
+        const std::vector<std::size_t> order{3u, 1u, 2u, 0u};
+        std::vector<std::size_t> executed;
+        MG::run_in_parallel(order, 1u, [&executed](const std::size_t idx) { executed.push_back(idx); });
+        ut::expect( executed==order );
+       };
+
+    ut::should("rethrow the exception of the lowest index") = []
+       {
+        try{
+            MG::run_in_parallel(8u, 4u, [](const std::size_t idx)
+               {
+                if( idx==5u or idx==6u ) throw std::runtime_error{ std::format("{}",idx) };
+               });
+            ut::expect(false) << "should throw\n";
+           }
+        catch( std::runtime_error& e )
+           {
+            ut::expect( ut::that % std::string_view(e.what())=="5"sv );
+           }
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
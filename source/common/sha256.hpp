@@ -0,0 +1,194 @@
+#pragma once
+//  ---------------------------------------------
+//  SHA-256 digest of a byte sequence, to address
+//  contents where a collision is not tolerable
+//  ---------------------------------------------
+//  #include "sha256.hpp" // MG::sha256_hasher, MG::sha256_of()
+//  ---------------------------------------------
+#include <array>
+#include <algorithm> // std::min
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <string>
+#include <string_view>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace MG //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// As specified in FIPS 180-4, the result doesn't depend on
+// how the data is split among the update() calls
+class sha256_hasher final
+{
+ public:
+    using digest_t = std::array<std::uint8_t,32>;
+
+ private:
+    std::array<std::uint32_t,8> m_state
+       {
+        0x6A09E667u, 0xBB67AE85u, 0x3C6EF372u, 0xA54FF53Au,
+        0x510E527Fu, 0x9B05688Cu, 0x1F83D9ABu, 0x5BE0CD19u
+       };
+    std::uint64_t m_total_size = 0u;
+    std::array<std::uint8_t,64> m_block {};
+    std::size_t m_block_size = 0u;
+
+ public:
+    constexpr sha256_hasher& update(std::string_view bytes) noexcept
+       {
+        m_total_size += bytes.size();
+        while( not bytes.empty() )
+           {
+            const std::size_t n = std::min(bytes.size(), m_block.size() - m_block_size);
+            for( std::size_t i=0; i<n; ++i )
+               {
+                m_block[m_block_size + i] = static_cast<std::uint8_t>(bytes[i]);
+               }
+            m_block_size += n;
+            bytes.remove_prefix(n);
+            if( m_block_size==m_block.size() )
+               {
+                process_block();
+                m_block_size = 0u;
+               }
+           }
+        return *this;
+       }
+
+    [[nodiscard]] constexpr digest_t digest() const noexcept
+       {
+        sha256_hasher h{*this}; // Padding a copy
+        const std::uint64_t bits_count = m_total_size * 8u;
+        h.m_block[h.m_block_size++] = 0x80u;
+        if( h.m_block_size>56u )
+           {
+            while( h.m_block_size<64u ) h.m_block[h.m_block_size++] = 0u;
+            h.process_block();
+            h.m_block_size = 0u;
+           }
+        while( h.m_block_size<56u ) h.m_block[h.m_block_size++] = 0u;
+        for( std::size_t i=0; i<8u; ++i )
+           {
+            h.m_block[56u+i] = static_cast<std::uint8_t>(bits_count >> (56u - 8u*i));
+           }
+        h.process_block();
+
+        digest_t result{};
+        for( std::size_t i=0; i<h.m_state.size(); ++i )
+           {
+            for( std::size_t j=0; j<4u; ++j )
+               {
+                result[4u*i + j] = static_cast<std::uint8_t>(h.m_state[i] >> (24u - 8u*j));
+               }
+           }
+        return result;
+       }
+
+ private:
+    [[nodiscard]] static constexpr std::uint32_t rotr(const std::uint32_t x, const unsigned int n) noexcept
+       {
+        return (x >> n) | (x << (32u - n));
+       }
+
+    constexpr void process_block() noexcept
+       {
+        constexpr std::array<std::uint32_t,64> k
+           {
+            0x428A2F98u, 0x71374491u, 0xB5C0FBCFu, 0xE9B5DBA5u, 0x3956C25Bu, 0x59F111F1u, 0x923F82A4u, 0xAB1C5ED5u,
+            0xD807AA98u, 0x12835B01u, 0x243185BEu, 0x550C7DC3u, 0x72BE5D74u, 0x80DEB1FEu, 0x9BDC06A7u, 0xC19BF174u,
+            0xE49B69C1u, 0xEFBE4786u, 0x0FC19DC6u, 0x240CA1CCu, 0x2DE92C6Fu, 0x4A7484AAu, 0x5CB0A9DCu, 0x76F988DAu,
+            0x983E5152u, 0xA831C66Du, 0xB00327C8u, 0xBF597FC7u, 0xC6E00BF3u, 0xD5A79147u, 0x06CA6351u, 0x14292967u,
+            0x27B70A85u, 0x2E1B2138u, 0x4D2C6DFCu, 0x53380D13u, 0x650A7354u, 0x766A0ABBu, 0x81C2C92Eu, 0x92722C85u,
+            0xA2BFE8A1u, 0xA81A664Bu, 0xC24B8B70u, 0xC76C51A3u, 0xD192E819u, 0xD6990624u, 0xF40E3585u, 0x106AA070u,
+            0x19A4C116u, 0x1E376C08u, 0x2748774Cu, 0x34B0BCB5u, 0x391C0CB3u, 0x4ED8AA4Au, 0x5B9CCA4Fu, 0x682E6FF3u,
+            0x748F82EEu, 0x78A5636Fu, 0x84C87814u, 0x8CC70208u, 0x90BEFFFAu, 0xA4506CEBu, 0xBEF9A3F7u, 0xC67178F2u
+           };
+
+        std::array<std::uint32_t,64> w {};
+        for( std::size_t i=0; i<16u; ++i )
+           {
+            w[i] = (static_cast<std::uint32_t>(m_block[4u*i]) << 24u) | (static_cast<std::uint32_t>(m_block[4u*i+1u]) << 16u) |
+                   (static_cast<std::uint32_t>(m_block[4u*i+2u]) << 8u) | static_cast<std::uint32_t>(m_block[4u*i+3u]);
+           }
+        for( std::size_t i=16u; i<64u; ++i )
+           {
+            const std::uint32_t s0 = rotr(w[i-15u], 7u) ^ rotr(w[i-15u], 18u) ^ (w[i-15u] >> 3u);
+            const std::uint32_t s1 = rotr(w[i-2u], 17u) ^ rotr(w[i-2u], 19u) ^ (w[i-2u] >> 10u);
+            w[i] = w[i-16u] + s0 + w[i-7u] + s1;
+           }
+
+        std::uint32_t a=m_state[0], b=m_state[1], c=m_state[2], d=m_state[3], e=m_state[4], f=m_state[5], g=m_state[6], h=m_state[7];
+        for( std::size_t i=0; i<64u; ++i )
+           {
+            const std::uint32_t t1 = h + (rotr(e, 6u) ^ rotr(e, 11u) ^ rotr(e, 25u)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            const std::uint32_t t2 = (rotr(a, 2u) ^ rotr(a, 13u) ^ rotr(a, 22u)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+           }
+        m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+        m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+       }
+};
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] constexpr sha256_hasher::digest_t sha256_of(const std::string_view bytes) noexcept
+{
+    return sha256_hasher{}.update(bytes).digest();
+}
+
+//---------------------------------------------------------------------------
+[[nodiscard]] inline std::string to_hex(const sha256_hasher::digest_t& digest)
+{
+    static constexpr std::string_view hex_digits = "0123456789abcdef";
+    std::string s;
+    s.reserve(2u * digest.size());
+    for( const std::uint8_t byte : digest )
+       {
+        s += hex_digits[byte >> 4u];
+        s += hex_digits[byte & 0xFu];
+       }
+    return s;
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"MG::sha256_hasher"> sha256_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("MG::sha256_of()") = []
+   {
+    ut::expect( ut::that % MG::to_hex(MG::sha256_of(""sv))=="e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"sv );
+    ut::expect( ut::that % MG::to_hex(MG::sha256_of("abc"sv))=="ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"sv );
+    ut::expect( ut::that % MG::to_hex(MG::sha256_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"sv))=="248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"sv );
+    ut::expect( ut::that % MG::to_hex(MG::sha256_of("The quick brown fox jumps over the lazy dog"sv))=="d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592"sv );
+   };
+
+ut::test("MG::sha256_hasher split updates") = []
+   {
+    const std::string content(150u, 'x');
+    const auto expected = MG::sha256_of(content);
+    for( std::size_t i=0; i<=content.size(); i+=7u )
+       {
+        MG::sha256_hasher hasher;
+        hasher.update(std::string_view{content}.substr(0,i)).update(std::string_view{content}.substr(i));
+        ut::expect( hasher.digest()==expected ) << "split at " << i << '\n';
+       }
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
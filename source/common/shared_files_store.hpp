@@ -0,0 +1,219 @@
+#pragma once
+//  ---------------------------------------------
+//  A directory of files addressed by a key,
+//  shareable among concurrent processes
+//  ---------------------------------------------
+//  #include "shared_files_store.hpp" // sys::shared_files_store
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <utility> // std::pair
+#include <algorithm> // std::ranges::sort
+#include <atomic>
+#include <chrono>
+#include <random> // std::random_device
+#include <format>
+
+#include "filesystem_utilities.hpp" // fs::*
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace sys //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// Each entry is a directory '<dir>/<key[0..1]>/<key>' containing named files.
+// An entry is prepared in '<dir>/tmp' and then renamed in place, so who
+// finds it sees it complete; the same for the removal. The entries used
+// less recently (directory time, updated when found) are removed when
+// the total size exceeds the limit
+class shared_files_store final
+{
+ public:
+    struct stats_t final
+       {
+        std::size_t hits_count = 0u;
+        std::size_t misses_count = 0u;
+        std::size_t inserts_count = 0u;
+       };
+
+ private:
+    fs::path m_dir;
+    std::uintmax_t m_max_size;
+    std::atomic<std::size_t> m_hits_count{0u};
+    std::atomic<std::size_t> m_misses_count{0u};
+    std::atomic<std::size_t> m_inserts_count{0u};
+    static constexpr std::size_t inserts_per_trim = 32u; // Keep the size in check also in long runs
+
+ public:
+    shared_files_store(fs::path dir, const std::uintmax_t max_size)
+      : m_dir{ std::move(dir) }
+      , m_max_size{ max_size }
+       {
+        fs::create_directories(m_dir / "tmp");
+       }
+
+    [[nodiscard]] const fs::path& dir() const noexcept { return m_dir; }
+
+    [[nodiscard]] stats_t stats() const noexcept
+       {
+        return { m_hits_count.load(), m_misses_count.load(), m_inserts_count.load() };
+       }
+
+    //-----------------------------------------------------------------------
+    // The directory of the entry, marked as recently used
+    [[nodiscard]] std::optional<fs::path> find(const std::string_view key)
+       {
+        fs::path entry_dir = entry_dir_of(key);
+        std::error_code ec;
+        if( not fs::is_directory(entry_dir, ec) )
+           {
+            ++m_misses_count;
+            return {};
+           }
+        fs::last_write_time(entry_dir, fs::file_time_type::clock::now(), ec);
+        ++m_hits_count;
+        return entry_dir;
+       }
+
+    //-----------------------------------------------------------------------
+    // Files given as {name in entry, path to copy}. If another process
+    // inserted the same key in the meantime, the existing entry is kept
+    void insert(const std::string_view key, const std::vector<std::pair<std::string_view,fs::path>>& files)
+       {
+        const fs::path temp_dir = unique_temp_path_for(key);
+        std::error_code ec;
+        try{
+            fs::create_directory(temp_dir);
+            for( const auto& [name, file_path] : files )
+               {
+                fs::copy_file(file_path, temp_dir / name);
+               }
+            const fs::path entry_dir = entry_dir_of(key);
+            fs::create_directories(entry_dir.parent_path());
+            fs::rename(temp_dir, entry_dir, ec);
+           }
+        catch(...)
+           {
+            fs::remove_all(temp_dir, ec);
+            throw;
+           }
+        if( ec )
+           {// Already there
+            fs::remove_all(temp_dir, ec);
+           }
+        else if( ++m_inserts_count % inserts_per_trim == 0u )
+           {
+            trim();
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Remove the least recently used entries exceeding the size limit
+    void trim()
+       {
+        struct entry_t final
+           {
+            fs::path dir;
+            fs::file_time_type time;
+            std::uintmax_t size = 0u;
+           };
+        std::vector<entry_t> entries;
+        std::uintmax_t total_size = 0u;
+
+        std::error_code ec;
+        for( const auto& group : fs::directory_iterator(m_dir, ec) )
+           {
+            if( not group.is_directory(ec) or group.path().filename()=="tmp" ) continue;
+            for( const auto& entry : fs::directory_iterator(group.path(), ec) )
+               {
+                entry_t e{ entry.path(), fs::last_write_time(entry.path(), ec), 0u };
+                for( const auto& file : fs::directory_iterator(entry.path(), ec) )
+                   {
+                    const auto file_size = file.file_size(ec);
+                    if( not ec ) e.size += file_size;
+                   }
+                total_size += e.size;
+                entries.push_back( std::move(e) );
+               }
+           }
+        if( total_size<=m_max_size )
+           {
+            return;
+           }
+
+        std::ranges::sort(entries, [](const entry_t& a, const entry_t& b) noexcept { return a.time<b.time; });
+        for( const auto& entry : entries )
+           {
+            if( total_size<=m_max_size ) break;
+            // Moved away first, so it disappears in a single step
+            const fs::path removed_dir = unique_temp_path_for( entry.dir.filename().string() );
+            fs::rename(entry.dir, removed_dir, ec);
+            if( not ec )
+               {
+                fs::remove_all(removed_dir, ec);
+               }
+            total_size -= entry.size;
+           }
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] fs::path entry_dir_of(const std::string_view key) const
+       {
+        return m_dir / key.substr(0, 2) / key;
+       }
+
+    //-----------------------------------------------------------------------
+    // Unique also among processes
+    [[nodiscard]] fs::path unique_temp_path_for(const std::string_view key) const
+       {
+        static std::atomic<unsigned int> counter{0u};
+        return m_dir / "tmp" / std::format("{}.{:x}.{:x}.{}", key, std::random_device{}(), std::chrono::steady_clock::now().time_since_epoch().count(), ++counter);
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"sys::shared_files_store"> shared_files_store_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("sys::shared_files_store") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto file_a = dir.create_file("a.txt", "aaaa"sv);
+    const auto file_b = dir.create_file("b.txt", "bbbbbb"sv);
+    sys::shared_files_store store(dir.path() / "store", 16u);
+
+    ut::expect( not store.find("k1"sv).has_value() );
+    store.insert("k1"sv, {{"a"sv, file_a.path()}, {"b"sv, file_b.path()}});
+    const auto entry_dir = store.find("k1"sv);
+    ut::expect( entry_dir.has_value() and fs::exists(*entry_dir / "b") );
+    ut::expect( entry_dir.has_value() and test::read_file_content((*entry_dir / "a").string())=="aaaa"sv );
+
+    store.insert("k1"sv, {{"a"sv, file_b.path()}}); // Existing entry is kept
+    ut::expect( entry_dir.has_value() and test::read_file_content((*entry_dir / "a").string())=="aaaa"sv );
+
+    store.insert("k2"sv, {{"a"sv, file_a.path()}});
+    fs::last_write_time(*entry_dir, fs::file_time_type::clock::now() - std::chrono::hours{1});
+    store.trim(); // 14 bytes, ok
+    ut::expect( store.find("k1"sv).has_value() and store.find("k2"sv).has_value() );
+
+    store.insert("k3"sv, {{"b"sv, file_b.path()}});
+    fs::last_write_time(*entry_dir, fs::file_time_type::clock::now() - std::chrono::hours{1});
+    store.trim(); // 20 bytes, the least recently used goes away
+    ut::expect( not store.find("k1"sv).has_value() );
+    ut::expect( store.find("k2"sv).has_value() and store.find("k3"sv).has_value() );
+    ut::expect( ut::that % store.stats().inserts_count==3u );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,7 @@
 //  #include "string_conversions.hpp" // str::to_num_or<>()
 //  ---------------------------------------------
 #include <string_view>
+#include <concepts> // std::integral
 #include <expected>
 #include <charconv> // std::from_chars
 #include <stdexcept> // std::runtime_error
@@ -30,6 +31,21 @@ template<typename T>
     return result;
 }
 
+//---------------------------------------------------------------------------
+// Convert a string_view to integer in the given base (non throwing)
+template<std::integral T>
+[[nodiscard]] constexpr std::expected<T, std::string> to_num_or(const std::string_view sv, const int base) noexcept
+{
+    T result;
+    const auto it_end = sv.data() + sv.size();
+    const auto [it, ec] = std::from_chars(sv.data(), it_end, result, base);
+    if( ec!=std::errc() or it!=it_end )
+       {
+        return std::unexpected( std::format("\"{}\" is not a valid base {} number", sv, base) );
+       }
+    return result;
+}
+
 
 //---------------------------------------------------------------------------
 // Convert a string_view to number (throwing)
@@ -90,6 +106,9 @@ ut::test("str::to_num_or<>") = []
         ut::log << "got value " << num.value() << '\n';
         ut::expect( false ) << "-42 shouldn't be a valid unsigned short";
        }
+
+    ut::expect( ut::that % str::to_num_or<unsigned int>("ff", 16).value_or(0u)==255u );
+    ut::expect( not str::to_num_or<unsigned int>("fg", 16).has_value() );
    };
 
 ut::test("str::to_num<>") = []
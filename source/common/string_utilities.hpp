@@ -7,6 +7,7 @@
 //#include <concepts> // std::convertible_to
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "ascii_predicates.hpp" // ascii::*
 
@@ -153,6 +154,36 @@ namespace str //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
     return sv;
 }
 
+//---------------------------------------------------------------------------
+// Split a command line in arguments, honoring single or double quotes
+[[nodiscard]] constexpr std::vector<std::string> split_args(const std::string_view line)
+{
+    std::vector<std::string> args;
+    std::size_t i = 0;
+    while( i<line.size() )
+       {
+        while( i<line.size() and ascii::is_space(line[i]) ) ++i;
+        if( i>=line.size() ) break;
+
+        std::string arg;
+        while( i<line.size() and not ascii::is_space(line[i]) )
+           {
+            if( line[i]=='\"' or line[i]=='\'' )
+               {// Quoted part
+                const char quot = line[i++];
+                while( i<line.size() and line[i]!=quot ) arg += line[i++];
+                if( i<line.size() ) ++i; // Skip closing quote
+               }
+            else
+               {
+                arg += line[i++];
+               }
+           }
+        args.push_back( std::move(arg) );
+       }
+    return args;
+}
+
 //---------------------------------------------------------------------------
 // Replace all occurrences in a string
 //constexpr void replace_all(std::string& s, const std::string& from, const std::string& to)
@@ -266,6 +297,15 @@ ut::test("str::unquoted()") = []
     ut::expect( ut::that % str::unquoted(""sv)==""sv );
    };
 
+ut::test("str::split_args()") = []
+   {
+    ut::expect( str::split_args(""sv).empty() );
+    ut::expect( str::split_args("  \t "sv).empty() );
+    ut::expect( str::split_args("a bb  ccc"sv)==std::vector<std::string>{"a", "bb", "ccc"} );
+    ut::expect( str::split_args(" convert \"my dir/a.h\" --to 'out dir' "sv)==std::vector<std::string>{"convert", "my dir/a.h", "--to", "out dir"} );
+    ut::expect( str::split_args("--to=\"a b\"c"sv)==std::vector<std::string>{"--to=a bc"} );
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -31,6 +31,7 @@ class string_write final
        }
 
     [[nodiscard]] const std::string& str() const noexcept { return m_string; }
+    [[nodiscard]] std::string release() noexcept { return std::move(m_string); }
 };
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -50,6 +51,7 @@ ut::test("streaming in") = []
     
     ss << 'c' << "iao"sv;
     ut::expect( ut::that % ss.str()=="ciao"sv );
+    ut::expect( ut::that % ss.release()=="ciao"sv );
    };
 
 };///////////////////////////////////////////////////////////////////////////
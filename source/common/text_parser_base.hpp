@@ -10,6 +10,7 @@
 #include <concepts> // std::predicate
 #include <limits> // std::numeric_limits<>
 #include <array>
+#include <algorithm> // std::ranges::all_of, std::ranges::count
 #include <format>
 
 #include "parsers_common.hpp" // parse::error
@@ -99,6 +100,16 @@ class ParserBase
         return parse::error(std::move(msg), m_file_path.empty() ? "buffer"s : m_file_path, ln_idx);
        }
 
+    //-----------------------------------------------------------------------
+    // Resume from a codepoint found otherwise, knowing its line
+    constexpr void jump_to(const std::size_t byte_offset, const std::size_t line) noexcept
+       {
+        m_buf.restore_context( {byte_offset} );
+        m_line = line;
+        m_curr_codepoint = utxt::codepoint::null; // Not an endline
+        get_next();
+       }
+
     //-----------------------------------------------------------------------
     // Extract next codepoint from buffer
     [[maybe_unused]] constexpr bool get_next() noexcept
@@ -315,71 +326,72 @@ class ParserBase
     template<char32_t end_codepoint>
     [[nodiscard]] constexpr std::string_view get_bytes_until()
        {
-        return get_bytes_until_and_skip(ascii::is<end_codepoint>, ascii::is_always_false<char32_t>);
+        if constexpr( is_searchable(end_codepoint) )
+           {
+            const std::string_view sv = get_bytes_before<end_codepoint>();
+            get_next(); // Skip termination codepoint
+            return sv;
+           }
+        else
+           {
+            return get_bytes_until_and_skip(ascii::is<end_codepoint>, ascii::is_always_false<char32_t>);
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // As get_bytes_until(ascii::is<end_codepoint>), but the codepoints in
+    // between are not extracted: the end is searched in the encoded bytes
+    //const auto bytes = parser.get_bytes_before<U'<'>();
+    template<char32_t end_codepoint>
+    [[nodiscard]] constexpr std::string_view get_bytes_before()
+       {
+        const std::size_t start = m_curr_codepoint_byte_offset;
+        if( not skip_before<end_codepoint>() )
+           {
+            throw create_parse_error( "Unexpected end (termination not found)" );
+           }
+        return m_buf.get_view_between(start, m_curr_codepoint_byte_offset);
+       }
+
+    //-----------------------------------------------------------------------
+    // Move to the next end_codepoint searching it in the encoded bytes,
+    // returns false (without moving) if not found
+    template<char32_t end_codepoint>
+    [[nodiscard]] constexpr bool skip_before()
+       {
+        static_assert( is_searchable(end_codepoint) );
+        static constexpr auto end_bytes = encode_ascii<1>({end_codepoint});
+        const std::size_t i_end = find_code_units({end_bytes.data(), end_bytes.size()});
+        if( i_end==std::string_view::npos )
+           {
+            return false;
+           }
+        move_to(i_end);
+        return true;
        }
 
     //-----------------------------------------------------------------------
     //const auto bytes = parser.get_bytes_until<U'*',U'/'>();
+    // The end sequence is searched in the encoded bytes, jumping over the
+    // content (typically long comments, CDATA sections) without extracting
+    // its codepoints
     template<char32_t end_seq1, char32_t end_seq2, char32_t... end_seqtail>
     [[nodiscard]] constexpr std::string_view get_bytes_until()
        {
-        using end_block_arr_t = std::array<char32_t, 2+sizeof...(end_seqtail)>;
-        static constexpr end_block_arr_t end_block_arr{end_seq1, end_seq2, end_seqtail...};
-        constexpr std::u32string_view end_block(end_block_arr.data(), end_block_arr.size());
-        using preceding_match_t = std::array<bool, end_block_arr.size()-1u>;
-        static constexpr preceding_match_t preceding_match = [](const end_block_arr_t& end_blk) constexpr
-           {
-            preceding_match_t a;
-            a[0] = true;
-            for(std::size_t i=1; i<a.size(); ++i)
-               {
-                a[i] = a[i-1] and end_blk[i-1]==end_blk[i];
-               }
-            return a;
-           }(end_block_arr);
-
+        static constexpr std::array<char32_t, 2+sizeof...(end_seqtail)> end_block_arr{end_seq1, end_seq2, end_seqtail...};
+        static_assert( std::ranges::all_of(end_block_arr, [](const char32_t cp) noexcept { return is_searchable(cp); }) );
+        static constexpr auto end_block_bytes = encode_ascii<end_block_arr.size()>(end_block_arr);
 
-        const auto start = save_context();
-        std::size_t content_end_byte_pos = start.curr_codepoint_byte_offset;
-        std::size_t i = 0; // Matching codepoint index
-        do {
-            if( got(end_block[i]) )
-               {// Matches a codepoint in end_block
-                // If it's the first of end_block...
-                if( i==0 )
-                   {// ...Store the offset of the possible end of collected content
-                    content_end_byte_pos = m_curr_codepoint_byte_offset;
-                   }
-                // If it's the last of end_block...
-                if( ++i>=end_block.size() )
-                   {// ...I'm done
-                    //notify_issue( std::format("matched! cp:{} collected:{}", utxt::to_utf8(curr_codepoint()), m_buf.get_slice_between(start.curr_codepoint_byte_offset, content_end_byte_pos)) );
-                    get_next(); // Skip last end_block codepoint
-                    return m_buf.get_view_between(start.curr_codepoint_byte_offset, content_end_byte_pos);
-                   }
-               }
-            else if( i>0 )
-               {// Last didn't match and there was a partial match
-                // Check what of the partial match can be salvaged
-                do {
-                    if( got(end_block[--i]) )
-                       {// Last matches a codepoint in end block
-                        if( preceding_match[i] )
-                           {
-                            content_end_byte_pos = m_curr_codepoint_byte_offset - i;
-                            ++i;
-                            break;
-                           }
-                       }
-                   }
-                while( i>0 );
-               }
-            //notify_issue( std::format("cp:{} collected:{} matched:{}", utxt::to_utf8(curr_codepoint()), m_buf.get_slice_between(start.curr_codepoint_byte_offset, content_end_byte_pos), utxt::to_utf8(end_block.substr(0, i))) );
+        const std::size_t start = m_curr_codepoint_byte_offset;
+        const std::size_t i_end = find_code_units({end_block_bytes.data(), end_block_bytes.size()});
+        if( i_end==std::string_view::npos )
+           {
+            const std::u32string_view end_block(end_block_arr.data(), end_block_arr.size());
+            throw create_parse_error(std::format("Unclosed content (\"{}\" not found)",utxt::to_utf8(end_block)), m_line);
            }
-        while( get_next() );
-
-        restore_context( start ); // Strong guarantee
-        throw create_parse_error(std::format("Unclosed content (\"{}\" not found)",utxt::to_utf8(end_block)), start.line);
+        move_to(i_end + end_block_bytes.size() - code_unit_size);
+        get_next(); // Skip last end_block codepoint
+        return m_buf.get_view_between(start, i_end);
        }
 
 
@@ -439,6 +451,73 @@ class ParserBase
        }
 
  private:
+    static constexpr std::size_t code_unit_size = ENC==utxt::Enc::UTF8 ? 1u : ((ENC==utxt::Enc::UTF16LE or ENC==utxt::Enc::UTF16BE) ? 2u : 4u);
+
+    //-----------------------------------------------------------------------
+    // The code units of an ascii codepoint can't be part of other
+    // codepoints, so it can be searched in the bytes
+    [[nodiscard]] static constexpr bool is_searchable(const char32_t cp) noexcept
+       {
+        return cp<0x80 and cp!=U'\n' and cp!=utxt::codepoint::null; // Lines are counted by get_next()
+       }
+
+    //-----------------------------------------------------------------------
+    template<std::size_t N>
+    [[nodiscard]] static constexpr std::array<char, N*code_unit_size> encode_ascii(const std::array<char32_t,N>& codepoints) noexcept
+       {
+        constexpr bool big_endian = ENC==utxt::Enc::UTF16BE or ENC==utxt::Enc::UTF32BE;
+        std::array<char, N*code_unit_size> bytes{};
+        for( std::size_t i=0; i<N; ++i )
+           {
+            bytes[i*code_unit_size + (big_endian ? code_unit_size-1u : 0u)] = static_cast<char>(codepoints[i]);
+           }
+        return bytes;
+       }
+
+    //-----------------------------------------------------------------------
+    // From the current codepoint. The search of the first byte is vectorized
+    // by the standard library (memchr), the code units must be aligned
+    [[nodiscard]] constexpr std::size_t find_code_units(const std::string_view units) const noexcept
+       {
+        if( not has_codepoint() )
+           {
+            return std::string_view::npos;
+           }
+        const std::string_view bytes = m_buf.bytes();
+        std::size_t pos = bytes.find(units, m_curr_codepoint_byte_offset);
+        while( pos!=std::string_view::npos and pos%code_unit_size!=0u )
+           {
+            pos = bytes.find(units, pos+1u);
+           }
+        return pos;
+       }
+
+    //-----------------------------------------------------------------------
+    // Jump forward to the codepoint at the given offset, found otherwise
+    constexpr void move_to(const std::size_t byte_offset) noexcept
+       {
+        assert( byte_offset>=m_curr_codepoint_byte_offset );
+        if( byte_offset==m_curr_codepoint_byte_offset )
+           {
+            return;
+           }
+        const std::string_view skipped = m_buf.get_view_between(m_curr_codepoint_byte_offset, byte_offset);
+        std::size_t lines_count = 0u;
+        if constexpr( code_unit_size==1u )
+           {
+            lines_count = static_cast<std::size_t>(std::ranges::count(skipped, '\n'));
+           }
+        else
+           {
+            static constexpr auto endline_bytes = encode_ascii<1>({U'\n'});
+            for( std::size_t pos = skipped.find(endline_bytes.data(), 0u, endline_bytes.size()); pos!=std::string_view::npos; pos = skipped.find(endline_bytes.data(), pos+1u, endline_bytes.size()) )
+               {
+                if( pos%code_unit_size==0u ) ++lines_count;
+               }
+           }
+        jump_to(byte_offset, m_line + lines_count);
+       }
+
     //-----------------------------------------------------------------------
     void advance_of(const std::size_t bytes_num)
        {
@@ -628,6 +707,23 @@ ut::test("end block edge case 2") = [&notify_sink]
     expect( parser.get_bytes_until<U'-',U'-',U'>'>()=="---"sv and parser.got(U'a') );
    };
 
+ut::test("searching encoded bytes") = [&notify_sink]
+   {
+    // u"a\n㰀Ā਀Ā<b\n*\n*/c": contains misaligned '<' and '\n' code units
+    text::ParserBase<UTF16LE> parser{ "a\0" "\n\0" "\0\x3C" "\0\x01" "\0\x0A" "\0\x01" "<\0" "b\0" "\n\0" "*\0" "\n\0" "*\0" "/\0" "c\0"sv };
+    parser.set_on_notify_issue(notify_sink);
+
+    expect( parser.got(U'a') and parser.curr_line()==1u );
+    expect( parser.get_bytes_before<U'<'>()=="a\0" "\n\0" "\0\x3C" "\0\x01" "\0\x0A" "\0\x01"sv );
+    expect( parser.got(U'<') and parser.curr_line()==2u and parser.curr_codepoint_byte_offset()==12u );
+    expect( parser.get_bytes_before<U'<'>().empty() and parser.got(U'<') ) << "already at the end\n";
+    expect( parser.get_next() and parser.got(U'b') );
+    expect( parser.get_bytes_until<U'*',U'/'>()=="b\0" "\n\0" "*\0" "\n\0"sv );
+    expect( parser.got(U'c') and parser.curr_line()==4u );
+    expect( throws<parse::error>([&parser] { [[maybe_unused]] auto sv = parser.get_bytes_before<U'<'>(); }) ) << "missing end should throw\n";
+    expect( parser.got(U'c') and parser.curr_line()==4u ) << "no movement when not found\n";
+   };
+
 ut::test("numbers") = [&notify_sink]
    {
     text::ParserBase<UTF8> parser
@@ -2,10 +2,16 @@
 //  ---------------------------------------------
 //  Parse xml format (unicode text buffer)
 //  ---------------------------------------------
-//  #include "text_parser_xml.hpp" // text::xml::Parser
+//  #include "text_parser_xml.hpp" // text::xml::Parser, text::xml::StreamParser, text::xml::find_open_tag(), text::xml::starts_with_tag_name()
 //  ---------------------------------------------
+#include <optional>
+#include <vector>
+#include <span>
+#include <algorithm> // std::ranges::count, std::ranges::find
+
 #include "text_parser_base.hpp" // text::ParserBase, parse::*
 #include "string_map.hpp" // MG::string_map<>
+#include "chunked_input.hpp" // sys::chunked_input
 
 
 
@@ -13,19 +19,23 @@
 namespace text { namespace xml
 {
 
+/////////////////////////////////////////////////////////////////////////////
+enum class event_type : char
+   {
+    NONE = '\0'
+   ,COMMENT // <!-- ... -->
+   ,TEXT // >...<
+   ,OPENTAG // <tag attr1 attr2=val>
+   ,CLOSETAG // </tag> or />
+   ,PROCINST // <? ... ?>
+   ,SPECIALBLOCK // <!xxx ... !>
+   };
+
+
 /////////////////////////////////////////////////////////////////////////////
 class ParserEvent final
 {
-    enum class type : char
-       {
-        NONE = '\0'
-       ,COMMENT // <!-- ... -->
-       ,TEXT // >...<
-       ,OPENTAG // <tag attr1 attr2=val>
-       ,CLOSETAG // </tag> or />
-       ,PROCINST // <? ... ?>
-       ,SPECIALBLOCK // <!xxx ... !>
-       };
+    using type = event_type;
 
  public:
     using Attributes = MG::string_map<std::u32string, std::optional<std::u32string>>;
@@ -133,13 +143,105 @@ class ParserEvent final
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+// An event referring to the parsed bytes, in their original encoding:
+// nothing is allocated (the attributes storage is reused) and nothing is
+// decoded. Names are compared with needles encoded as the bytes, ex:
+//   const std::string lib_tag = utxt::encode_as<ENC>(U"lib"sv);
+//   if( parser.next_event_view().is_open_tag(lib_tag) ) ...
+template<utxt::Enc ENC>
+class ParserEventView final
+{
+    using type = event_type;
+
+ public:
+    struct attribute_t final
+       {
+        std::string_view name;
+        std::optional<std::string_view> value;
+       };
+
+ private:
+    std::string_view m_value; // Tag name or content
+    std::size_t m_start_byte_offset = 0;
+    std::size_t m_start_line = 1;
+    std::vector<attribute_t> m_attributes;
+    type m_type = type::NONE;
+
+ public:
+    constexpr void set(const type typ, const std::string_view bytes) noexcept
+       {
+        m_type = typ;
+        m_value = bytes;
+        m_attributes.clear();
+       }
+
+    constexpr void set_as_none() noexcept { set(type::NONE, {}); }
+    constexpr void set_as_comment(const std::string_view bytes) noexcept { set(type::COMMENT, bytes); }
+    constexpr void set_as_text(const std::string_view bytes) noexcept { set(type::TEXT, bytes); }
+    constexpr void set_as_proc_instr(const std::string_view bytes) noexcept { set(type::PROCINST, bytes); }
+    constexpr void set_as_special_block(const std::string_view bytes) noexcept { set(type::SPECIALBLOCK, bytes); }
+    constexpr void set_as_open_tag(const std::string_view nam)
+       {
+        if( nam.empty() )
+           {
+            throw std::runtime_error{"Empty open tag"};
+           }
+        set(type::OPENTAG, nam);
+       }
+    constexpr void set_as_close_tag(const std::string_view nam)
+       {
+        if( nam.empty() )
+           {
+            throw std::runtime_error{"Empty open tag"};
+           }
+        set(type::CLOSETAG, nam);
+       }
+
+    [[nodiscard]] constexpr type get_type() const noexcept { return m_type; }
+    [[nodiscard]] constexpr std::string_view value() const noexcept { return m_value; }
+    [[nodiscard]] constexpr std::u32string decoded_value() const { return utxt::to_utf32<ENC>(m_value); }
+
+    constexpr void set_start_byte_offset(const std::size_t byte_offset) noexcept { m_start_byte_offset = byte_offset; }
+    [[nodiscard]] constexpr std::size_t start_byte_offset() const noexcept { return m_start_byte_offset; }
+    constexpr void set_start_line(const std::size_t line) noexcept { m_start_line = line; }
+    [[nodiscard]] constexpr std::size_t start_line() const noexcept { return m_start_line; } // Of the first codepoint, to jump_to() there
+
+    [[nodiscard]] constexpr std::span<const attribute_t> attributes() const noexcept { return m_attributes; }
+    constexpr void append_attribute(attribute_t&& attr) { m_attributes.push_back( std::move(attr) ); }
+    [[nodiscard]] constexpr const attribute_t* find_attribute(const std::string_view nam) const noexcept
+       {
+        const auto it = std::ranges::find(m_attributes, nam, &attribute_t::name);
+        return it!=m_attributes.end() ? &(*it) : nullptr;
+       }
+    [[nodiscard]] constexpr bool has_attribute_with_value(const std::string_view key, const std::string_view val) const noexcept
+       {
+        const attribute_t* const attrib = find_attribute(key);
+        return attrib and attrib->value.has_value() and attrib->value.value()==val;
+       }
+
+    [[nodiscard]] explicit constexpr operator bool() const noexcept { return m_type!=type::NONE; }
+    [[nodiscard]] constexpr bool is_comment() const noexcept { return m_type==type::COMMENT; }
+    [[nodiscard]] constexpr bool is_text() const noexcept { return m_type==type::TEXT; }
+    [[nodiscard]] constexpr bool is_open_tag() const noexcept { return m_type==type::OPENTAG; }
+    [[nodiscard]] constexpr bool is_close_tag() const noexcept { return m_type==type::CLOSETAG; }
+    [[nodiscard]] constexpr bool is_proc_instr() const noexcept { return m_type==type::PROCINST; }
+    [[nodiscard]] constexpr bool is_special_block() const noexcept { return m_type==type::SPECIALBLOCK; }
+
+    [[nodiscard]] constexpr bool is_open_tag(const std::string_view nam) const noexcept { return m_type==type::OPENTAG and m_value==nam; }
+    [[nodiscard]] constexpr bool is_close_tag(const std::string_view nam) const noexcept { return m_type==type::CLOSETAG and m_value==nam; }
+};
+
+
 
 /////////////////////////////////////////////////////////////////////////////
 template<utxt::Enc ENC>
 class Parser final : public text::ParserBase<ENC>
 {              using base = text::ParserBase<ENC>;
  private:
-    ParserEvent m_event; // Current event
+    ParserEventView<ENC> m_event_view; // Current event, as parsed
+    mutable ParserEvent m_event; // Current event, decoded when needed
+    mutable bool m_event_decoded = true;
     bool m_must_emit_tag_close_event = false; // To signal a deferred tag close
 
     class Options final
@@ -165,40 +267,67 @@ class Parser final : public text::ParserBase<ENC>
     [[nodiscard]] constexpr Options const& options() const noexcept { return m_Options; }
     [[nodiscard]] constexpr Options& options() noexcept { return m_Options; }
 
-    [[nodiscard]] constexpr ParserEvent const& curr_event() const noexcept { return m_event; }
-    [[nodiscard]] constexpr ParserEvent& mutable_curr_event() noexcept { return m_event; }
+    [[nodiscard]] constexpr ParserEventView<ENC> const& curr_event_view() const noexcept { return m_event_view; }
+    [[nodiscard]] constexpr bool is_empty_element() const noexcept { return m_event_view.is_open_tag() and m_must_emit_tag_close_event; } // <tag/>
+    [[nodiscard]] constexpr ParserEvent const& curr_event() const
+       {
+        if( not m_event_decoded )
+           {
+            decode_event();
+           }
+        return m_event;
+       }
+    [[nodiscard]] constexpr ParserEvent& mutable_curr_event()
+       {
+        [[maybe_unused]] const ParserEvent& event = curr_event();
+        return m_event;
+       }
 
     [[maybe_unused]] constexpr ParserEvent const& next_event()
        {
+        next_event_view();
+        return curr_event();
+       }
+
+    //-----------------------------------------------------------------------
+    // Resume parsing from a position, forgetting the pending events
+    constexpr void jump_to(const std::size_t byte_offset, const std::size_t line) noexcept
+       {
+        base::jump_to(byte_offset, line);
+        m_must_emit_tag_close_event = false;
+        m_event_decoded = true;
+       }
+
+    //-----------------------------------------------------------------------
+    // The event is decoded just if curr_event() is called
+    [[maybe_unused]] constexpr ParserEventView<ENC> const& next_event_view()
+       {
+        m_event_decoded = false;
         if( m_must_emit_tag_close_event )
            {
             m_must_emit_tag_close_event = false; // eat
-            m_event.set_as_close_tag( m_event.value() );
+            m_event_view.set_as_close_tag( m_event_view.value() );
            }
         else
            {
             try{
                 base::skip_any_space();
-                m_event.set_start_byte_offset( base::curr_codepoint_byte_offset() );
+                m_event_view.set_start_byte_offset( base::curr_codepoint_byte_offset() );
+                m_event_view.set_start_line( base::curr_line() );
                 if( base::has_codepoint() )
                    {
                     if( base::eat(U'<') )
                        {
                         parse_xml_markup();
                        }
-                    else if( options().is_collect_text_sections() )
-                       {
-                        m_event.set_as_text( base::collect_until(ascii::is<U'<'>) ); // Trim right?
-                       }
                     else
                        {
-                        [[maybe_unused]] const auto text = base::get_bytes_until(ascii::is<U'<'>); // Trim right?
-                        m_event.set_as_text();
+                        m_event_view.set_as_text( base::template get_bytes_before<U'<'>() ); // Trim right?
                        }
                    }
                 else
                    {// No more data!
-                    m_event.set_as_none();
+                    m_event_view.set_as_none();
                    }
                }
             catch(parse::error&)
@@ -211,41 +340,235 @@ class Parser final : public text::ParserBase<ENC>
                }
            }
 
-        return m_event;
+        return m_event_view;
+       }
+
+    //-----------------------------------------------------------------------
+    // To be called on an open tag event: skips the whole element content
+    // tracking the nesting depth, without producing events, attributes or
+    // text; the current event becomes the matching close tag
+    constexpr void skip_current_element(const bool forbid_nested_same_tag =false)
+       {
+        if( not m_event_view.is_open_tag() )
+           {
+            throw base::create_parse_error( "Not an element to skip (open tag expected)" );
+           }
+        if( m_must_emit_tag_close_event )
+           {// An empty element <tag/>
+            next_event_view();
+            return;
+           }
+
+        const std::string_view tag_name = m_event_view.value();
+        const auto start_line = base::curr_line();
+        std::size_t depth = 1u;
+        try{
+            while( base::template skip_before<U'<'>() )
+               {
+                const std::size_t markup_start = base::curr_codepoint_byte_offset();
+                const std::size_t markup_line = base::curr_line();
+                base::get_next(); // Skip '<'
+                if( base::eat(U'!') )
+                   {
+                    if( base::eat(U"--") )
+                       {// A comment ex. <!-- ... -->
+                        [[maybe_unused]] const auto sv = base::template get_bytes_until<U'-',U'-',U'>'>();
+                       }
+                    else if( base::eat(U"[CDATA["sv) )
+                       {// A CDATA section <![CDATA[ ... ]]>
+                        [[maybe_unused]] const auto sv = base::template get_bytes_until<U']',U']',U'>'>();
+                       }
+                    else
+                       {// A special block: ex. <!DOCTYPE HTML>
+                        [[maybe_unused]] const auto sv = base::template get_bytes_until<U'>'>();
+                       }
+                   }
+                else if( base::eat(U'?') )
+                   {// A processing instruction
+                    [[maybe_unused]] const auto sv = base::template get_bytes_until<U'?',U'>'>();
+                   }
+                else if( base::eat(U'/') )
+                   {// A close tag
+                    if( --depth==0u )
+                       {
+                        const std::string_view close_tag_name = get_tag_name();
+                        base::skip_any_space();
+                        if( close_tag_name!=tag_name or not base::eat(U'>') )
+                           {
+                            throw base::create_parse_error( std::format("Unmatched close tag of <{}>", utxt::reencode<ENC,utxt::Enc::UTF8>(tag_name)) );
+                           }
+                        m_event_decoded = false;
+                        m_event_view.set_start_byte_offset( markup_start );
+                        m_event_view.set_start_line( markup_line );
+                        m_event_view.set_as_close_tag( close_tag_name );
+                        return;
+                       }
+                    [[maybe_unused]] const auto sv = base::template get_bytes_until<U'>'>();
+                   }
+                else
+                   {// An open tag
+                    if( forbid_nested_same_tag and get_tag_name()==tag_name )
+                       {
+                        throw base::create_parse_error( std::format("Unexpected nested <{}>", utxt::reencode<ENC,utxt::Enc::UTF8>(tag_name)) );
+                       }
+                    if( skip_open_tag_rest() )
+                       {// A nested element
+                        ++depth;
+                       }
+                   }
+               }
+           }
+        catch(parse::error&)
+           {
+            throw;
+           }
+        catch(std::runtime_error& e)
+           {
+            throw base::create_parse_error( std::string(e.what()) );
+           }
+
+        throw base::create_parse_error( std::format("Unclosed <{}>", utxt::reencode<ENC,utxt::Enc::UTF8>(tag_name)), start_line );
+       }
+
+    //-----------------------------------------------------------------------
+    // Seek the open tag of a nested element (ex. "root/child/item")
+    // starting from the current level, skipping the other subtrees;
+    // returns false if not found
+    [[nodiscard]] constexpr bool seek_path(const std::u32string_view path)
+       {
+        std::size_t i = 0;
+        while( i<=path.size() )
+           {
+            const std::size_t i_end = std::min(path.find(U'/', i), path.size());
+            if( not seek_child_element(utxt::encode_as<ENC>(path.substr(i, i_end-i))) )
+               {
+                return false;
+               }
+            i = i_end + 1u;
+           }
+        return true;
        }
 
 
  private:
     //-----------------------------------------------------------------------
-    constexpr void parse_xml_markup()
+    // Seek the open tag among the next sibling elements, false
+    // when reaching the parent close tag
+    [[nodiscard]] constexpr bool seek_child_element(const std::string_view tag_name)
        {
-        if( base::eat(U'!') )
+        while( const auto& event = next_event_view() )
            {
-            if( base::eat(U"--") )
-               {// A comment ex. <!-- ... -->
-                if( options().is_collect_comment_text() )
+            if( event.is_open_tag() )
+               {
+                if( event.value()==tag_name )
                    {
-                    m_event.set_as_comment( base::template collect_until<U'-',U'-',U'>'>() );
+                    return true;
+                   }
+                skip_current_element();
+               }
+            else if( event.is_close_tag() )
+               {
+                return false;
+               }
+           }
+        return false;
+       }
+
+    //-----------------------------------------------------------------------
+    // Skip the name and attributes of an open tag,
+    // returns false in case of an empty element <tag/>
+    [[nodiscard]] constexpr bool skip_open_tag_rest()
+       {
+        bool empty_element = false;
+        while( base::has_codepoint() )
+           {
+            if( base::eat(U'>') )
+               {
+                return not empty_element;
+               }
+            empty_element = base::eat(U'/');
+            if( not empty_element )
+               {
+                if( base::eat(U'\"') )
+                   {// A quoted value can contain '>' or '/'
+                    [[maybe_unused]] const auto sv = base::template get_bytes_until<U'\"'>();
                    }
                 else
                    {
-                    [[maybe_unused]] const auto text = base::template get_bytes_until<U'-',U'-',U'>'>();
-                    m_event.set_as_comment();
+                    base::get_next();
                    }
                }
+           }
+        throw std::runtime_error{"Unclosed tag"};
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static constexpr std::u32string decoded(const std::string_view bytes)
+       {
+        return utxt::to_utf32<ENC>(bytes);
+       }
+
+    //-----------------------------------------------------------------------
+    constexpr void decode_event() const
+       {
+        m_event.set_start_byte_offset( m_event_view.start_byte_offset() );
+        switch( m_event_view.get_type() )
+           {
+            using enum event_type;
+            case NONE:
+                m_event.set_as_none();
+                break;
+
+            case COMMENT:
+                if( options().is_collect_comment_text() ) m_event.set_as_comment( decoded(m_event_view.value()) );
+                else m_event.set_as_comment();
+                break;
+
+            case TEXT:
+                if( options().is_collect_text_sections() ) m_event.set_as_text( decoded(m_event_view.value()) );
+                else m_event.set_as_text();
+                break;
+
+            case OPENTAG:
+                m_event.set_as_open_tag( decoded(m_event_view.value()) );
+                for( const auto& attr : m_event_view.attributes() )
+                   {
+                    std::optional<std::u32string> value;
+                    if( attr.value.has_value() ) value = decoded(attr.value.value());
+                    m_event.attributes().append( {decoded(attr.name), std::move(value)} );
+                   }
+                break;
+
+            case CLOSETAG:
+                m_event.set_as_close_tag( decoded(m_event_view.value()) );
+                break;
+
+            case PROCINST:
+                //m_event.set_as_proc_instr( decoded(m_event_view.value()) );
+                m_event.set_as_proc_instr(U""s);
+                break;
+
+            case SPECIALBLOCK:
+                m_event.set_as_special_block( decoded(m_event_view.value()) );
+                break;
+           }
+        m_event_decoded = true;
+       }
+
+    //-----------------------------------------------------------------------
+    constexpr void parse_xml_markup()
+       {
+        if( base::eat(U'!') )
+           {
+            if( base::eat(U"--") )
+               {// A comment ex. <!-- ... -->
+                m_event_view.set_as_comment( base::template get_bytes_until<U'-',U'-',U'>'>() );
+               }
             else if( base::eat(U'[') )
                {
                 if( base::eat(U"CDATA["sv) )
                    {// A CDATA section <![CDATA[ ... ]]>
-                    if( options().is_collect_text_sections() )
-                       {
-                        m_event.set_as_text( base::template collect_until<U']',U']',U'>'>() );
-                       }
-                    else
-                       {
-                        [[maybe_unused]] const auto text = base::template get_bytes_until<U']',U']',U'>'>();
-                        m_event.set_as_text();
-                       }
+                    m_event_view.set_as_text( base::template get_bytes_until<U']',U']',U'>'>() );
                    }
                 else
                    {// A conditional section <![CONDITION[ ... ]]>
@@ -258,19 +581,17 @@ class Parser final : public text::ParserBase<ENC>
                }
             else
                {// A special block: ex. <!DOCTYPE HTML>
-                m_event.set_as_special_block( base::template collect_until<U'>'>() );
-                //m_event.set_as_special_block( base::template collect_until(U"]>"sv) );
+                m_event_view.set_as_special_block( base::template get_bytes_until<U'>'>() );
+                //m_event_view.set_as_special_block( base::template get_bytes_until(U"]>"sv) );
                }
            }
         else if( base::eat(U'?') )
            {// A processing instruction ex. <?xml version="1.0" encoding="utf-8"?>
-            //m_event.set_as_proc_instr( base::template collect_until(U"?>") );
-            [[maybe_unused]] const auto text = base::template get_bytes_until<U'?',U'>'>();
-            m_event.set_as_proc_instr(U""s);
+            m_event_view.set_as_proc_instr( base::template get_bytes_until<U'?',U'>'>() );
            }
         else if( base::eat(U'/') )
            {// A close tag
-            m_event.set_as_close_tag( collect_tag_name() );
+            m_event_view.set_as_close_tag( get_tag_name() );
             base::skip_any_space();
             if( not base::eat(U'>') )
                {
@@ -279,20 +600,20 @@ class Parser final : public text::ParserBase<ENC>
            }
         else
            {// A tag
-            m_event.set_as_open_tag( collect_tag_name() );
+            m_event_view.set_as_open_tag( get_tag_name() );
             base::skip_any_space();
             if( not base::eat(U'>') )
                {
                 // Collect attributes
-                auto namval = collect_attribute();
-                while( not namval.first.empty() )
+                auto attr = get_attribute();
+                while( not attr.name.empty() )
                    {
-                    if( m_event.attributes().contains(namval.first) )
+                    if( m_event_view.find_attribute(attr.name) )
                        {
-                        throw base::create_parse_error( std::format("Duplicated attribute `{}`", utxt::to_utf8(namval.first)) );
+                        throw base::create_parse_error( std::format("Duplicated attribute `{}`", utxt::reencode<ENC,utxt::Enc::UTF8>(attr.name)) );
                        }
-                    m_event.attributes().append( std::move(namval) );
-                    namval = collect_attribute();
+                    m_event_view.append_attribute( std::move(attr) );
+                    attr = get_attribute();
                    }
 
                 // Detect immediate tag close
@@ -305,39 +626,39 @@ class Parser final : public text::ParserBase<ENC>
                 // Expect >
                 if( not base::eat(U'>') )
                    {
-                    throw base::create_parse_error( std::format("Tag `{}` must be closed with >", utxt::to_utf8(m_event.value())) );
+                    throw base::create_parse_error( std::format("Tag `{}` must be closed with >", utxt::reencode<ENC,utxt::Enc::UTF8>(m_event_view.value())) );
                    }
                }
            }
        }
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] constexpr ParserEvent::Attributes::item_type collect_attribute()
+    [[nodiscard]] constexpr ParserEventView<ENC>::attribute_t get_attribute()
        {
-        assert( not base::got_space() ); // collect_attribute() expects non-space char
-        ParserEvent::Attributes::item_type namval;
+        assert( not base::got_space() ); // get_attribute() expects non-space char
+        typename ParserEventView<ENC>::attribute_t attr;
 
-        namval.first = collect_attr_name();
-        if( not namval.first.empty() )
+        attr.name = get_attr_name();
+        if( not attr.name.empty() )
            {// Check possible value
             base::skip_any_space();
             if( base::eat(U'=') )
                {
                 base::skip_any_space();
-                namval.second = base::eat(U'\"') ? collect_quoted_attr_value()
-                                                      : collect_unquoted_attr_value();
+                attr.value = base::eat(U'\"') ? get_quoted_attr_value()
+                                              : get_unquoted_attr_value();
                 base::skip_any_space();
                }
            }
-        return namval;
+        return attr;
        }
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] constexpr std::u32string collect_tag_name()
+    [[nodiscard]] constexpr std::string_view get_tag_name()
        {
         base::skip_any_space();
         try{
-            return base::collect_until(ascii::is_space_or_any_of<U'>',U'/'>, ascii::is_punct_and_none_of<U'-',U':'>);
+            return base::get_bytes_until(ascii::is_space_or_any_of<U'>',U'/'>, ascii::is_punct_and_none_of<U'-',U':'>);
            }
         catch(std::exception& e)
            {
@@ -346,11 +667,11 @@ class Parser final : public text::ParserBase<ENC>
        }
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] constexpr std::u32string collect_attr_name()
+    [[nodiscard]] constexpr std::string_view get_attr_name()
        {
-        assert( not base::got_space() ); // collect_unquoted_attr_name() expects non-space char"
+        assert( not base::got_space() ); // get_attr_name() expects non-space char"
         try{
-            return base::collect_until(ascii::is_space_or_any_of<U'=',U'>',U'/'>, ascii::is_punct_and_none_of<U'-'>);
+            return base::get_bytes_until(ascii::is_space_or_any_of<U'=',U'>',U'/'>, ascii::is_punct_and_none_of<U'-'>);
            }
         catch(std::exception& e)
            {
@@ -359,10 +680,10 @@ class Parser final : public text::ParserBase<ENC>
        }
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] constexpr std::u32string collect_quoted_attr_value()
+    [[nodiscard]] constexpr std::string_view get_quoted_attr_value()
        {
         try{
-            return base::collect_until_and_skip(ascii::is<U'\"'>, ascii::is_endline<char32_t>);
+            return base::get_bytes_until_and_skip(ascii::is<U'\"'>, ascii::is_endline<char32_t>);
            }
         catch(std::exception& e)
            {
@@ -371,11 +692,11 @@ class Parser final : public text::ParserBase<ENC>
        }
 
     //-----------------------------------------------------------------------
-    [[nodiscard]] constexpr std::u32string collect_unquoted_attr_value()
+    [[nodiscard]] constexpr std::string_view get_unquoted_attr_value()
        {
-        assert( not base::got_space() ); // collect_unquoted_attr_value() expects non-space char"
+        assert( not base::got_space() ); // get_unquoted_attr_value() expects non-space char"
         try{
-            return base::collect_until(ascii::is_space_or_any_of<U'>',U'/'>, ascii::is_any_of<U'<',U'=',U'\"'>);
+            return base::get_bytes_until(ascii::is_space_or_any_of<U'>',U'/'>, ascii::is_any_of<U'<',U'=',U'\"'>);
            }
         catch(std::exception& e)
            {
@@ -385,6 +706,194 @@ class Parser final : public text::ParserBase<ENC>
 };
 
 
+
+/////////////////////////////////////////////////////////////////////////////
+// Parses an input read by chunks (ex. a pipe) keeping in memory just the
+// bytes of the current event: an event truncated by the end of the read
+// bytes is parsed again after reading more, so the event views are valid
+// until the next event. The event byte offsets are relative to the read
+// bytes: the input offset is given by curr_event_input_offset()
+template<utxt::Enc ENC>
+class StreamParser final
+{
+ private:
+    sys::chunked_input m_input;
+    std::optional<Parser<ENC>> m_parser; // Over the read bytes
+    fnotify_t m_on_notify_issue = Parser<ENC>::default_notify;
+    std::string m_file_path;
+
+ public:
+    explicit StreamParser(sys::chunked_input&& input)
+      : m_input{std::move(input)}
+       {
+        const std::string bom = utxt::encode_as<ENC>(U'\uFEFF');
+        while( m_input.bytes().size()<bom.size() and m_input.read_more(0u) ) ;
+        rebuild_parser_at(m_input.bytes().starts_with(bom) ? bom.size() : 0u, 1u);
+       }
+
+    [[nodiscard]] constexpr auto const& options() const noexcept { return m_parser->options(); }
+    [[nodiscard]] constexpr auto& options() noexcept { return m_parser->options(); }
+
+    void set_on_notify_issue(fnotify_t const& f)
+       {
+        m_on_notify_issue = f;
+        m_parser->set_on_notify_issue(f);
+       }
+    void set_file_path(std::string&& pth)
+       {
+        m_file_path = pth;
+        m_parser->set_file_path( std::move(pth) );
+       }
+
+    [[nodiscard]] constexpr std::size_t curr_line() const noexcept { return m_parser->curr_line(); }
+    [[nodiscard]] constexpr ParserEventView<ENC> const& curr_event_view() const noexcept { return m_parser->curr_event_view(); }
+    [[nodiscard]] constexpr ParserEvent const& curr_event() const { return m_parser->curr_event(); }
+    [[nodiscard]] constexpr std::size_t curr_event_input_offset() const noexcept { return m_input.base_offset() + curr_event_view().start_byte_offset(); }
+
+    [[maybe_unused]] ParserEvent const& next_event()
+       {
+        next_event_view();
+        return curr_event();
+       }
+
+    //-----------------------------------------------------------------------
+    [[maybe_unused]] ParserEventView<ENC> const& next_event_view()
+       {
+        // The event start is pinned, the preceding bytes can be forgotten
+        const std::size_t start_offset = m_input.base_offset() + (m_parser->has_codepoint() ? m_parser->curr_codepoint_byte_offset() : m_parser->curr_byte_offset());
+        const std::size_t start_line = m_parser->curr_line();
+        while( true )
+           {
+            try{
+                const ParserEventView<ENC>& event = m_parser->next_event_view();
+                if( m_parser->has_codepoint() or m_input.ended() )
+                   {// The event is followed by other bytes, so is complete
+                    return event;
+                   }
+               }
+            catch(parse::error&)
+               {
+                if( m_input.ended() ) throw;
+               }
+            // Could be truncated, parsing it again with more bytes
+            [[maybe_unused]] const bool got_more = m_input.read_more(start_offset);
+            rebuild_parser_at(start_offset, start_line);
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // As Parser::skip_current_element(), but the skipped subtree is
+    // traversed by events, not needing to have it all in memory
+    void skip_current_element()
+       {
+        if( not curr_event_view().is_open_tag() )
+           {
+            throw m_parser->create_parse_error( "Not an element to skip (open tag expected)" );
+           }
+        const auto start_line = curr_line();
+        std::size_t depth = 1u;
+        while( const auto& event = next_event_view() )
+           {
+            if( event.is_open_tag() )
+               {
+                ++depth;
+               }
+            else if( event.is_close_tag() and --depth==0u )
+               {
+                return;
+               }
+           }
+        throw m_parser->create_parse_error( "Unclosed element", start_line );
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    // The parser sees just the whole codepoints of the read bytes
+    void rebuild_parser_at(const std::size_t offset, const std::size_t line)
+       {
+        const std::string_view bytes = m_input.ended() ? m_input.bytes() : m_input.bytes().substr(0, utxt::whole_codepoints_size<ENC>(m_input.bytes()));
+        if( m_parser.has_value() )
+           {
+            const auto options = m_parser->options();
+            m_parser.emplace(bytes);
+            m_parser->options() = options;
+           }
+        else
+           {
+            m_parser.emplace(bytes);
+           }
+        m_parser->set_on_notify_issue(m_on_notify_issue);
+        m_parser->set_file_path( std::string(m_file_path) );
+        m_parser->jump_to(offset - m_input.base_offset(), line);
+       }
+};
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+struct tag_position_t final
+   {
+    std::size_t byte_offset; // Of '<'
+    std::size_t line;
+   };
+
+//---------------------------------------------------------------------------
+// Whether the bytes following '<' are the given tag name
+[[nodiscard]] constexpr bool starts_with_tag_name(const std::string_view markup, const std::string_view tag_name) noexcept
+{
+    return markup.starts_with(tag_name) and markup.size()>tag_name.size() and
+           (ascii::is_space(markup[tag_name.size()]) or markup[tag_name.size()]=='>' or markup[tag_name.size()]=='/');
+}
+
+//---------------------------------------------------------------------------
+// Locate the first open tag with the given name in UTF-8 (or ASCII) bytes
+// without decoding them: just looking for '<' and skipping comments,
+// CDATA sections and processing instructions. The search and the lines
+// counting rely on memchr() and on the vectorized count, a lot faster
+// than the parser events
+[[nodiscard]] constexpr std::optional<tag_position_t> find_open_tag(const std::string_view bytes, const std::string_view tag_name) noexcept
+{
+    const auto skip_to_end_of = [bytes](const std::size_t pos, const std::string_view end_mark) noexcept
+       {
+        const std::size_t i_end = bytes.find(end_mark, pos);
+        return i_end==std::string_view::npos ? std::string_view::npos : i_end + end_mark.size();
+       };
+
+    std::size_t pos = bytes.find('<');
+    while( pos!=std::string_view::npos )
+       {
+        const std::string_view markup = bytes.substr(pos+1u);
+        if( markup.starts_with("!--"sv) )
+           {
+            pos = skip_to_end_of(pos+4u, "-->"sv);
+           }
+        else if( markup.starts_with("![CDATA["sv) )
+           {
+            pos = skip_to_end_of(pos+9u, "]]>"sv);
+           }
+        else if( markup.starts_with('?') )
+           {
+            pos = skip_to_end_of(pos+2u, "?>"sv);
+           }
+        else if( starts_with_tag_name(markup, tag_name) )
+           {
+            const auto newlines_count = std::ranges::count(bytes.substr(0, pos), '\n');
+            return tag_position_t{ pos, static_cast<std::size_t>(newlines_count) + 1u };
+           }
+        else
+           {
+            ++pos;
+           }
+        if( pos!=std::string_view::npos )
+           {
+            pos = bytes.find('<', pos);
+           }
+       }
+    return {};
+}
+
+
 }}//:::::::::::::::::::::::::::::: text::xml ::::::::::::::::::::::::::::::::
 
 
@@ -556,6 +1065,156 @@ ut::test("generic xml") = [&notify_sink]
     expect( that % n_event==25u ) << "events number should match";
    };
 
+ut::test("text::xml::find_open_tag()") = [&notify_sink]
+   {
+    const std::string_view buf =
+        "<?xml version=\"1.0\"?>\n"
+        "<prj>\n"
+        "<!-- <libs> in comment -->\n"
+        "<code><![CDATA[ if a<libs> ]]></code>\n"
+        "<libsx/><?pi <libs> ?>\n"
+        "<libs  attr=\"1\">\n"
+        "  <lib/>\n"
+        "</libs>\n"
+        "</prj>\n"sv;
+
+    const auto pos = text::xml::find_open_tag(buf, "libs"sv);
+    expect( pos.has_value() and buf.substr(pos->byte_offset).starts_with("<libs  attr"sv) );
+    expect( pos.has_value() and pos->line==6u );
+    expect( not text::xml::find_open_tag(buf, "lib2"sv).has_value() );
+    expect( not text::xml::find_open_tag("<!-- <libs>"sv, "libs"sv).has_value() ) << "unclosed comment\n";
+
+    // The parser resumes from there
+    text::xml::Parser<utxt::Enc::UTF8> parser{buf};
+    parser.set_on_notify_issue(notify_sink);
+    parser.jump_to(pos.value().byte_offset, pos.value().line);
+    expect( parser.next_event().is_open_tag(U"libs"sv) and parser.curr_event().start_byte_offset()==pos.value().byte_offset );
+    expect( parser.next_event().is_open_tag(U"lib"sv) and parser.curr_line()==7u );
+   };
+
+ut::test("text::xml::ParserEventView") = [&notify_sink]
+   {
+    using enum utxt::Enc;
+    const std::string buf = utxt::encode_as<UTF16LE>(U"<!-- cmt --><root a=\"1\" b=\"àè\" c><item/>text</root>"sv);
+    text::xml::Parser<UTF16LE> parser{buf};
+    parser.set_on_notify_issue(notify_sink);
+    const auto encoded = [](const std::u32string_view s){ return utxt::encode_as<UTF16LE>(s); };
+
+    expect( parser.next_event_view().is_comment() );
+    expect( parser.curr_event_view().decoded_value()==U" cmt "sv );
+
+    const auto& root = parser.next_event_view();
+    expect( root.is_open_tag(encoded(U"root"sv)) and not root.is_open_tag(encoded(U"roo"sv)) );
+    expect( that % root.attributes().size()==3u );
+    expect( root.has_attribute_with_value(encoded(U"b"sv), encoded(U"àè"sv)) );
+    expect( root.find_attribute(encoded(U"c"sv)) and not root.find_attribute(encoded(U"c"sv))->value.has_value() );
+    expect( not root.find_attribute(encoded(U"d"sv)) );
+    expect( parser.curr_event().is_open_tag(U"root"sv) and parser.curr_event().has_attribute_with_value(U"a"sv, U"1"sv) ) << "should be decoded on demand\n";
+    expect( parser.curr_event().start_byte_offset()==root.start_byte_offset() );
+
+    expect( parser.next_event_view().is_open_tag(encoded(U"item"sv)) );
+    expect( parser.next_event_view().is_close_tag(encoded(U"item"sv)) );
+    expect( parser.next_event_view().is_text() and parser.curr_event_view().value()==encoded(U"text"sv) );
+    expect( parser.next_event().is_close_tag(U"root"sv) );
+    expect( not parser.next_event_view() );
+
+    // Jumping away from an empty element drops its pending close tag
+    parser.jump_to(0u, 1u);
+    expect( parser.next_event_view().is_comment() );
+    const std::size_t root_offset = parser.next_event_view().start_byte_offset();
+    expect( parser.next_event_view().is_open_tag(encoded(U"item"sv)) and parser.is_empty_element() );
+    parser.jump_to(root_offset, 1u);
+    expect( parser.next_event_view().is_open_tag(encoded(U"root"sv)) ) << "should resume at the given position\n";
+   };
+
+ut::test("skipping elements") = [&notify_sink]
+   {
+    using enum utxt::Enc;
+    const std::string buf = utxt::encode_as<UTF16LE>(U"<?xml version=\"1.0\"?>\n"
+                                                     U"<root>\n"
+                                                     U"  <code a=\"<x/>\">\n"
+                                                     U"    <code><!-- </code> --><empty/></code>\n"
+                                                     U"    <![CDATA[ </code> ]]>ò\n"
+                                                     U"  </code>\n"
+                                                     U"  <data>\n"
+                                                     U"    <item n=\"1\"/>\n"
+                                                     U"  </data>\n"
+                                                     U"</root>\n"sv);
+    text::xml::Parser<UTF16LE> parser{buf};
+    parser.set_on_notify_issue(notify_sink);
+
+    expect( parser.seek_path(U"root/data/item"sv) and parser.curr_event().has_attribute_with_value(U"n"sv, U"1"sv) );
+    expect( that % parser.curr_line()==8u );
+    expect( not parser.seek_path(U"other"sv) and parser.curr_event().is_close_tag(U"item"sv) ) << "should seek in the current element\n";
+    expect( not parser.seek_path(U"other"sv) and parser.curr_event().is_close_tag(U"data"sv) ) << "should stop at parent close tag\n";
+
+    parser.jump_to(0u, 1u);
+    expect( parser.seek_path(U"root/code"sv) and parser.curr_line()==3u and parser.curr_event_view().start_line()==3u );
+    parser.skip_current_element();
+    expect( parser.curr_event().is_close_tag(U"code"sv) and parser.curr_line()==6u and parser.curr_event_view().start_line()==6u );
+    expect( buf.substr(parser.curr_event().start_byte_offset()).starts_with(utxt::encode_as<UTF16LE>(U"</code>\n  <data>"sv)) );
+    expect( parser.next_event().is_open_tag(U"data"sv) );
+
+    const std::string unclosed_buf = utxt::encode_as<UTF16LE>(U"<root>\n<a>\n<b></b>\n</root>"sv);
+    text::xml::Parser<UTF16LE> unclosed_parser{unclosed_buf};
+    unclosed_parser.set_on_notify_issue(notify_sink);
+    expect( unclosed_parser.seek_path(U"root"sv) );
+    expect( throws<parse::error>([&unclosed_parser] { unclosed_parser.skip_current_element(); }) ) << "unclosed element should throw\n";
+
+    const std::string nested_buf = utxt::encode_as<UTF16LE>(U"<a><b><a/></b></a>"sv);
+    text::xml::Parser<UTF16LE> nested_parser{nested_buf};
+    nested_parser.set_on_notify_issue(notify_sink);
+    expect( nested_parser.seek_path(U"a"sv) );
+    expect( throws<parse::error>([&nested_parser] { nested_parser.skip_current_element(true); }) ) << "forbidden nested element should throw\n";
+   };
+
+ut::test("text::xml::StreamParser") = [&notify_sink]
+   {
+    using enum utxt::Enc;
+    const std::string buf = utxt::encode_as<UTF16LE>(U"\uFEFF<?xml version=\"1.0\" encoding=\"UTF-16\"?>\n"
+                                                     U"<!-- comment with 😀 -->\n"
+                                                     U"<root a=\"àè😀\">\n"
+                                                     U"  <code><![CDATA[ <x> ∆∆∆ ]]></code>\n"
+                                                     U"  <item n=\"1\"/>text ò 😀\n"
+                                                     U"  <data><sub/><sub/></data>\n"
+                                                     U"</root>\n"sv);
+    text::xml::Parser<UTF16LE> parser{std::string_view{buf}.substr(2)};
+    parser.options().set_collect_comment_text(true);
+    parser.options().set_collect_text_sections(true);
+    parser.set_on_notify_issue(notify_sink);
+
+    // Chunks that split the code units and the surrogate pairs
+    text::xml::StreamParser<UTF16LE> stream_parser{ sys::chunked_input::from_bytes(buf, 5u) };
+    stream_parser.options().set_collect_comment_text(true);
+    stream_parser.options().set_collect_text_sections(true);
+    stream_parser.set_on_notify_issue(notify_sink);
+
+    std::size_t n_event = 0u;
+    while( const text::xml::ParserEvent& event = parser.next_event() )
+       {
+        ++n_event;
+        const text::xml::ParserEvent& stream_event = stream_parser.next_event();
+        expect( to_string(stream_event)==to_string(event) ) << "event " << n_event << " got: " << to_string(stream_event) << '\n';
+        expect( stream_event.attributes()==event.attributes() ) << "event " << n_event << " attributes should match\n";
+        expect( stream_parser.curr_line()==parser.curr_line() ) << "event " << n_event << " line should match\n";
+        expect( stream_parser.curr_event_input_offset()==event.start_byte_offset()+2u ) << "event " << n_event << " offset should match\n";
+       }
+    expect( that % n_event==16u );
+    expect( not stream_parser.next_event_view() );
+
+    text::xml::StreamParser<UTF16LE> skipping_parser{ sys::chunked_input::from_bytes(buf, 3u) };
+    skipping_parser.set_on_notify_issue(notify_sink);
+    while( skipping_parser.next_event_view() and not skipping_parser.curr_event().is_open_tag(U"code"sv) ) ;
+    skipping_parser.skip_current_element();
+    expect( skipping_parser.curr_event().is_close_tag(U"code"sv) and skipping_parser.curr_line()==4u );
+    expect( skipping_parser.next_event().is_open_tag(U"item"sv) );
+
+    text::xml::StreamParser<UTF8> unclosed_parser{ sys::chunked_input::from_bytes("<root>\n<!-- unclosed"sv, 4u) };
+    unclosed_parser.set_on_notify_issue(notify_sink);
+    expect( unclosed_parser.next_event().is_open_tag(U"root"sv) );
+    expect( throws<parse::error>([&unclosed_parser] { [[maybe_unused]] auto ev = unclosed_parser.next_event_view(); }) ) << "unclosed comment should throw\n";
+   };
+
 ut::test("unclosed comment") = [&notify_sink]
    {
     const std::string_view buf = "<!--\n\n\n\n";
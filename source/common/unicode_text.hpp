@@ -283,6 +283,46 @@ template<> constexpr char32_t extract_codepoint<Enc::UTF32BE>(const std::string_
 }
 
 
+//---------------------------------------------------------------------------
+// The size of the leading bytes made of whole codepoints, to not split
+// a codepoint straddling the end of a chunk of a bigger input
+template<Enc ENC>
+[[nodiscard]] constexpr std::size_t whole_codepoints_size(const std::string_view bytes) noexcept
+{
+    if constexpr( ENC==Enc::UTF8 )
+       {
+        // Checking the last leading byte
+        for( std::size_t i=bytes.size(); i>0u and bytes.size()-i<4u; )
+           {
+            const auto byte = static_cast<unsigned char>(bytes[--i]);
+            if( (byte & 0xC0u)!=0x80u )
+               {// Not a continuation byte
+                const std::size_t len = byte<0x80u ? 1u : (byte>=0xF0u ? 4u : (byte>=0xE0u ? 3u : 2u));
+                return (i+len)<=bytes.size() ? bytes.size() : i;
+               }
+           }
+        return bytes.size(); // Invalid anyway
+       }
+    else if constexpr( ENC==Enc::UTF16LE or ENC==Enc::UTF16BE )
+       {
+        const std::size_t size = bytes.size() - (bytes.size() % 2u);
+        if( size>=2u )
+           {
+            const auto high_byte = static_cast<unsigned char>(bytes[ENC==Enc::UTF16LE ? size-1u : size-2u]);
+            if( (high_byte & 0xFCu)==0xD8u )
+               {// A first surrogate
+                return size-2u;
+               }
+           }
+        return size;
+       }
+    else
+       {
+        return bytes.size() - (bytes.size() % 4u);
+       }
+}
+
+
 //---------------------------------------------------------------------------
 // Encode: Write a codepoint according to encoding and endianness
 template<Enc enc> constexpr void append_codepoint(const char32_t codepoint, std::string& bytes) noexcept;
@@ -425,6 +465,7 @@ template<Enc ENC> class bytes_buffer_t final
         return m_byte_buf.substr(from_byte_pos, to_byte_pos-from_byte_pos);
        }
 
+    [[nodiscard]] constexpr std::string_view bytes() const noexcept { return m_byte_buf; }
     [[nodiscard]] constexpr std::size_t byte_pos() const noexcept { return m_current_byte_offset; }
     constexpr void advance_of(const std::size_t bytes_num) noexcept { m_current_byte_offset += bytes_num; }
     constexpr void set_as_depleted() noexcept { m_current_byte_offset = m_byte_buf.size(); }
@@ -820,6 +861,18 @@ ut::test("utxt::bytes_buffer_t") = []
     expect( not buf.has_bytes() and not buf.has_codepoint() and buf.byte_pos()==6 );
    };
 
+ut::test("utxt::whole_codepoints_size") = []
+   {
+    expect( utxt::whole_codepoints_size<UTF8>(""sv)==0u );
+    expect( utxt::whole_codepoints_size<UTF8>("a\xE2\x88\x86"sv)==4u ); // a∆
+    expect( utxt::whole_codepoints_size<UTF8>("a\xE2\x88"sv)==1u );
+    expect( utxt::whole_codepoints_size<UTF8>("a\xF0\x9F\x98"sv)==1u );
+    expect( utxt::whole_codepoints_size<UTF16LE>("a\0\x3D\xD8\x00\xDE"sv)==6u ); // a😀
+    expect( utxt::whole_codepoints_size<UTF16LE>("a\0\x3D\xD8\x00"sv)==2u );
+    expect( utxt::whole_codepoints_size<UTF16BE>("\0a\xD8\x3D"sv)==2u );
+    expect( utxt::whole_codepoints_size<UTF32LE>("a\0\0\0b\0"sv)==4u );
+   };
+
 ut::test("utxt::encode_as<>(bytes)") = []
    {
     expect( utxt::encode_as<UTF8>(""sv) == ""sv) << "Implicit utf-8 empty string should be empty\n";
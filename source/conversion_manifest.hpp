@@ -0,0 +1,240 @@
+#pragma once
+//  ---------------------------------------------
+//  Records the state of the converted files
+//  to skip the unchanged ones
+//  ---------------------------------------------
+//  #include "conversion_manifest.hpp" // ll::conversion_manifest
+//  ---------------------------------------------
+#include <cstdint> // std::uint64_t, std::int64_t
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm> // std::ranges::sort
+#include <format>
+
+#include "filesystem_utilities.hpp" // fs::*, fsu::*
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "file_write.hpp" // sys::file_write()
+#include "options_map.hpp" // MG::options_map
+#include "bytes_hash.hpp" // MG::hash_of()
+#include "string_conversions.hpp" // str::to_num_or<>()
+
+using namespace std::literals; // "..."sv
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// A text file in the output directory:
+//   lltool-manifest
+//   tool: <tool id>
+//   options: <conversion options>
+//   <hash> <size> <mtime> <input path>
+//   ...
+// A different tool or options invalidates all the entries
+class conversion_manifest final
+{
+ public:
+    static constexpr std::string_view file_name = ".lltool-manifest"sv;
+
+    struct file_state_t final
+       {
+        std::uint64_t hash = 0u;
+        std::uintmax_t size = 0u;
+        std::int64_t mtime = 0;
+       };
+
+    struct check_t final
+       {
+        file_state_t state;
+        bool changed = true;
+       };
+
+ private:
+    fs::path m_path;
+    std::string m_header;
+    std::unordered_map<std::string, file_state_t> m_entries;
+
+ public:
+    conversion_manifest(const fs::path& dir, const std::string_view tool_id, const MG::options_map& conv_options)
+      : m_path{ dir / file_name }
+      , m_header{ std::format("lltool-manifest\ntool: {}\noptions: {}\n", tool_id, conv_options.to_string()) }
+       {
+        if( fsu::exists(m_path) )
+           {
+            load();
+           }
+       }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_entries.size(); }
+
+    //-----------------------------------------------------------------------
+    // The content is read and hashed only if size or time don't match
+    [[nodiscard]] check_t check(const fs::path& input_file_path) const
+       {
+        check_t result;
+        result.state.size = fs::file_size(input_file_path);
+        result.state.mtime = get_mtime_of(input_file_path);
+
+        const auto it = m_entries.find( key_of(input_file_path) );
+        if( it!=m_entries.end() and it->second.size==result.state.size )
+           {
+            if( it->second.mtime==result.state.mtime )
+               {
+                result.state.hash = it->second.hash;
+                result.changed = false;
+                return result;
+               }
+            result.state.hash = hash_content_of(input_file_path);
+            result.changed = result.state.hash!=it->second.hash;
+            return result;
+           }
+
+        result.state.hash = hash_content_of(input_file_path);
+        return result;
+       }
+
+    //-----------------------------------------------------------------------
+    void set(const fs::path& input_file_path, const file_state_t& state)
+       {
+        m_entries.insert_or_assign( key_of(input_file_path), state );
+       }
+
+    //-----------------------------------------------------------------------
+    void save() const
+       {
+        std::vector<const decltype(m_entries)::value_type*> sorted_entries;
+        sorted_entries.reserve( m_entries.size() );
+        for( const auto& entry : m_entries ) sorted_entries.push_back(&entry);
+        std::ranges::sort(sorted_entries, [](const auto* a, const auto* b) noexcept { return a->first<b->first; });
+
+        fs::path temp_path{ m_path };
+        temp_path += ".tmp";
+           {sys::file_write out_file{ temp_path.string().c_str() };
+            out_file << m_header;
+            for( const auto* entry : sorted_entries )
+               {
+                out_file << std::format("{} {} {} {}\n", MG::to_hex(entry->second.hash), entry->second.size, entry->second.mtime, entry->first);
+               }
+           }
+        fs::rename(temp_path, m_path);
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    void load()
+       {
+        const sys::memory_mapped_file manifest_mapped{ m_path.string().c_str() };
+        std::string_view bytes = manifest_mapped.as_string_view();
+        if( not bytes.starts_with(m_header) )
+           {// Generated with a different tool or options
+            return;
+           }
+        bytes.remove_prefix(m_header.size());
+
+        while( not bytes.empty() )
+           {
+            std::size_t i_end = bytes.find('\n');
+            if( i_end==std::string_view::npos ) i_end = bytes.size();
+            const std::string_view line = bytes.substr(0, i_end);
+            bytes.remove_prefix( std::min(i_end+1, bytes.size()) );
+
+            // <hash> <size> <mtime> <path>
+            const std::size_t i1 = line.find(' ');
+            const std::size_t i2 = i1==std::string_view::npos ? i1 : line.find(' ', i1+1);
+            const std::size_t i3 = i2==std::string_view::npos ? i2 : line.find(' ', i2+1);
+            if( i3==std::string_view::npos )
+               {// Corrupted, ignore all
+                m_entries.clear();
+                return;
+               }
+            const auto hash = str::to_num_or<std::uint64_t>(line.substr(0, i1), 16);
+            const auto size = str::to_num_or<std::uintmax_t>(line.substr(i1+1, i2-i1-1));
+            const auto mtime = str::to_num_or<std::int64_t>(line.substr(i2+1, i3-i2-1));
+            if( not hash.has_value() or not size.has_value() or not mtime.has_value() )
+               {
+                m_entries.clear();
+                return;
+               }
+            m_entries.insert_or_assign( std::string(line.substr(i3+1)), file_state_t{hash.value(), size.value(), mtime.value()} );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::string key_of(const fs::path& file_path)
+       {
+        return fs::absolute(file_path).lexically_normal().string();
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::int64_t get_mtime_of(const fs::path& file_path)
+       {
+        return static_cast<std::int64_t>( fs::last_write_time(file_path).time_since_epoch().count() );
+       }
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::uint64_t hash_content_of(const fs::path& file_path)
+       {
+        const sys::memory_mapped_file file_mapped{ file_path.string().c_str() };
+        return MG::hash_of( file_mapped.as_string_view() );
+       }
+};
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"conversion_manifest"> conversion_manifest_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("ll::conversion_manifest") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto in = dir.create_file("in.h", "#define vqEx1 vq1 // descr 1\n"sv);
+    const MG::options_map options{"sort"};
+
+       {ll::conversion_manifest manifest(dir.path(), "tool"sv, options);
+        ut::expect( ut::that % manifest.size()==0u );
+        const auto chk = manifest.check(in.path());
+        ut::expect( chk.changed ) << "unrecorded file should be changed\n";
+        manifest.set(in.path(), chk.state);
+        manifest.save();
+       }
+
+    ut::should("detect an unchanged file") = [&]
+       {
+        ll::conversion_manifest manifest(dir.path(), "tool"sv, options);
+        ut::expect( ut::that % manifest.size()==1u );
+        ut::expect( not manifest.check(in.path()).changed );
+       };
+
+    ut::should("invalidate on different options") = [&]
+       {
+        ll::conversion_manifest manifest(dir.path(), "tool"sv, MG::options_map{"timestamp"});
+        ut::expect( ut::that % manifest.size()==0u );
+       };
+
+    ut::should("invalidate on different tool") = [&]
+       {
+        ll::conversion_manifest manifest(dir.path(), "other-tool"sv, options);
+        ut::expect( ut::that % manifest.size()==0u );
+       };
+
+    ut::should("detect a changed file") = [&]
+       {
+        in << "#define vqEx2 vq2 // descr 2\n"sv;
+        ll::conversion_manifest manifest(dir.path(), "tool"sv, options);
+        ut::expect( manifest.check(in.path()).changed );
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
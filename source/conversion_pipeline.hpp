@@ -0,0 +1,243 @@
+#pragma once
+//  ---------------------------------------------
+//  Convert many libraries overlapping the
+//  mapping, parsing and writing of each one
+//  ---------------------------------------------
+//  #include "conversion_pipeline.hpp" // ll::convert_libraries_pipelined()
+//  ---------------------------------------------
+#include <array>
+#include <vector>
+#include <memory> // std::unique_ptr
+#include <chrono>
+#include <atomic>
+#include <thread> // std::jthread
+#include <exception> // std::exception_ptr
+#include <string>
+#include <format>
+
+#include "libraries_converter.hpp" // ll::parse_library(), ll::write_library()
+#include "bounded_queue.hpp" // MG::bounded_queue<>
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// To see which stage is the bottleneck
+struct pipeline_stats_t final
+   {
+    struct stage_t final
+       {
+        std::string_view name;
+        std::chrono::nanoseconds busy_time{};
+        std::size_t items_count = 0u;
+       };
+
+    std::array<stage_t,3> stages{{ {"map"sv}, {"parse"sv}, {"write"sv} }};
+    std::array<MG::queue_stats_t,2> queues; // Between the stages
+    std::chrono::nanoseconds elapsed_time{};
+
+    [[nodiscard]] std::string to_string() const
+       {
+        using ms = std::chrono::duration<double, std::milli>;
+        std::string s = std::format("Pipeline elapsed time: {:.1f} ms\n", ms(elapsed_time).count());
+        for( std::size_t i=0; i<stages.size(); ++i )
+           {
+            s += std::format("  {} stage: {} files, busy {:.1f} ms\n", stages[i].name, stages[i].items_count, ms(stages[i].busy_time).count());
+            if( i<queues.size() )
+               {
+                s += std::format("  {}->{} queue: max depth {}, average depth {:.2f}, full {} times\n", stages[i].name, stages[i+1].name, queues[i].max_depth, queues[i].average_depth(), queues[i].full_count);
+               }
+           }
+        return s;
+       }
+   };
+
+
+//---------------------------------------------------------------------------
+// Three threads: mapping (and prefetching) the next file, parsing the
+// current one, writing the previous one, connected by bounded queues.
+// As in convert_libraries(), the issues are forwarded in input order and
+// the first failing file (in input order) stops the pipeline and rethrows:
+// the files before it are still converted, the ones after are skipped
+pipeline_stats_t convert_libraries_pipelined(const std::vector<fs::path>& input_files_paths, const fs::path& output_path, const bool can_overwrite, const MG::options_map& conv_options, const std::size_t queues_depth, fnotify_t const& notify_issue)
+{
+    struct mapped_t final
+       {
+        std::size_t idx;
+        file_type type;
+        outpaths_t outpaths;
+        std::unique_ptr<sys::memory_mapped_file> mapped; // Won't move, the library refers to it
+       };
+    struct parsed_t final
+       {
+        std::size_t idx;
+        outpaths_t outpaths;
+        std::unique_ptr<sys::memory_mapped_file> mapped;
+        std::unique_ptr<plcb::Library> lib;
+       };
+
+    pipeline_stats_t stats;
+    std::vector<MG::issues> files_issues(input_files_paths.size());
+    std::vector<std::exception_ptr> errors(input_files_paths.size());
+    std::atomic<std::size_t> first_failed_idx{input_files_paths.size()}; // None
+    MG::bounded_queue<mapped_t> mapped_queue(queues_depth);
+    MG::bounded_queue<parsed_t> parsed_queue(queues_depth);
+
+    const auto timed = [](pipeline_stats_t::stage_t& stage, auto&& work)
+       {
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        stage.busy_time += std::chrono::steady_clock::now() - start;
+        ++stage.items_count;
+       };
+
+    const auto set_failed = [&errors, &first_failed_idx](const std::size_t idx) noexcept
+       {
+        errors[idx] = std::current_exception();
+        std::size_t failed_idx = first_failed_idx.load(std::memory_order_relaxed);
+        while( idx<failed_idx and not first_failed_idx.compare_exchange_weak(failed_idx, idx, std::memory_order_relaxed) ) {}
+       };
+
+    const auto is_after_failure = [&first_failed_idx](const std::size_t idx) noexcept
+       {
+        return idx>first_failed_idx.load(std::memory_order_relaxed);
+       };
+
+    const auto start = std::chrono::steady_clock::now();
+       {std::jthread mapper([&]()
+           {
+            for( std::size_t idx=0; idx<input_files_paths.size() and not is_after_failure(idx); ++idx )
+               {
+                const fs::path& input_file_path = input_files_paths[idx];
+                mapped_t item{ idx, file_type::unknown, {}, {} };
+                try{
+                    timed(stats.stages[0], [&]()
+                       {
+                        item.type = recognize_file_type( input_file_path.string() );
+                        item.outpaths = set_output_paths(input_file_path, item.type, output_path, can_overwrite_outputs(can_overwrite, conv_options));
+                        item.mapped = std::make_unique<sys::memory_mapped_file>( input_file_path.string().c_str() );
+                        item.mapped->prefetch();
+                       });
+                   }
+                catch(...)
+                   {
+                    set_failed(idx);
+                    break;
+                   }
+                if( not mapped_queue.push(std::move(item)) ) break;
+               }
+            mapped_queue.close();
+           });
+
+        std::jthread parser([&]()
+           {
+            while( auto item = mapped_queue.pop() )
+               {
+                if( is_after_failure(item->idx) ) continue; // Just draining
+                const fs::path& input_file_path = input_files_paths[item->idx];
+                parsed_t parsed{ item->idx, std::move(item->outpaths), std::move(item->mapped), {} };
+                try{
+                    timed(stats.stages[1], [&]()
+                       {
+                        parsed.lib = std::make_unique<plcb::Library>( input_file_path.stem().string() );
+                        parse_library(*parsed.lib, input_file_path.string(), item->type, parsed.mapped->as_string_view(), conv_options, std::ref(files_issues[parsed.idx]));
+                        parsed.lib->throw_if_incoherent();
+                       });
+                   }
+                catch(...)
+                   {
+                    set_failed(parsed.idx);
+                    continue;
+                   }
+                if( not parsed_queue.push(std::move(parsed)) ) break;
+               }
+            parsed_queue.close();
+           });
+
+        // Writing in this thread
+        while( auto parsed = parsed_queue.pop() )
+           {
+            if( is_after_failure(parsed->idx) ) continue; // Just draining
+            try{
+                timed(stats.stages[2], [&]()
+                   {
+                    if( not write_library(*parsed->lib, parsed->outpaths.pll, parsed->outpaths.plclib, conv_options) )
+                       {
+                        files_issues[parsed->idx]( std::format("Nothing to do for: \"{}\""sv, input_files_paths[parsed->idx].string()) );
+                       }
+                   });
+               }
+            catch(...)
+               {
+                set_failed(parsed->idx);
+               }
+           }
+       } // Join all
+    stats.elapsed_time = std::chrono::steady_clock::now() - start;
+    stats.queues[0] = mapped_queue.stats();
+    stats.queues[1] = parsed_queue.stats();
+
+    forward_issues_in_order(files_issues, notify_issue);
+    for( const auto& error : errors )
+       {
+        if( error ) std::rethrow_exception(error);
+       }
+    return stats;
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"conversion_pipeline"> conversion_pipeline_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("ll::convert_libraries_pipelined()") = []
+   {
+    test::TemporaryDirectory dir;
+    std::vector<fs::path> inputs;
+    inputs.push_back( dir.create_file("~empty1.pll", "\n"sv).path() );
+    inputs.push_back( dir.create_file("sample-lib.pll", sample_lib_pll).path() );
+    inputs.push_back( dir.create_file("sample-def.h", sample_def_header).path() );
+    inputs.push_back( dir.create_file("~empty2.pll", "\n"sv).path() );
+    const fs::path out_dir = dir.path() / "out";
+    ll::prepare_output_dir(out_dir, false, [](std::string&&)noexcept{});
+
+    ut::should("convert all the files") = [&]
+       {
+        MG::issues issues;
+        const auto stats = ll::convert_libraries_pipelined(inputs, out_dir, false, MG::options_map{"plclib-indent:2"}, 1u, std::ref(issues));
+        ut::expect( ut::that % issues.size()==2u ) << "two issues expected\n";
+        ut::expect( issues.size()==2u and issues.at(0).contains("~empty1"sv) and issues.at(1).contains("~empty2"sv) );
+        ut::expect( ut::that % stats.stages[2].items_count==4u );
+        ut::expect( ut::that % stats.queues[0].pushed_count==4u );
+        ut::expect( ut::that % test::read_file_content((out_dir / "sample-lib.plclib").string()) == sample_lib_plclib );
+        ut::expect( fs::exists(out_dir / "sample-def.pll") );
+        ut::expect( not stats.to_string().empty() );
+       };
+
+    ut::should("stop at the first error") = [&]
+       {
+        ut::expect( ut::throws([&]{ [[maybe_unused]] const auto stats = ll::convert_libraries_pipelined(inputs, out_dir, false, {}, 2u, [](std::string&&)noexcept{}); }) ) << "should not overwrite\n";
+       };
+
+    ut::should("convert the files before the failing one") = [&]
+       {
+        const fs::path out_dir2 = dir.path() / "out2";
+        ll::prepare_output_dir(out_dir2, false, [](std::string&&)noexcept{});
+        const std::vector<fs::path> inputs2 = { inputs[2], inputs[1], dir.create_file("~bad.h", "garbage {{{\n"sv).path(), inputs[0] };
+        ut::expect( ut::throws([&]{ [[maybe_unused]] const auto stats = ll::convert_libraries_pipelined(inputs2, out_dir2, false, {}, 1u, [](std::string&&)noexcept{}); }) );
+        ut::expect( fs::exists(out_dir2 / "sample-def.pll") and fs::exists(out_dir2 / "sample-lib.plclib") ) << "files before the failing one should be written\n";
+        ut::expect( not fs::exists(out_dir2 / "~empty1.plclib") ) << "files after the failing one should be skipped\n";
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
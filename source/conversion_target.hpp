@@ -0,0 +1,26 @@
+#pragma once
+//  ---------------------------------------------
+//  An output of the conversions with its
+//  own options
+//  ---------------------------------------------
+//  #include "conversion_target.hpp" // ll::conversion_target_t
+//  ---------------------------------------------
+#include <filesystem> // std::filesystem
+namespace fs = std::filesystem;
+
+#include "options_map.hpp" // MG::options_map
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// An output directory with its own options
+struct conversion_target_t final
+   {
+    fs::path output_path;
+    MG::options_map options;
+   };
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
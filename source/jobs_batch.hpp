@@ -0,0 +1,436 @@
+#pragma once
+//  ---------------------------------------------
+//  Execute many tasks in a single run
+//  ---------------------------------------------
+//  #include "jobs_batch.hpp" // app::run_jobs_batch()
+//  ---------------------------------------------
+#include <stdexcept> // std::invalid_argument
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional> // std::function
+#include <mutex> // std::unique_lock
+#include <memory> // std::shared_ptr
+#include <optional>
+#include <cstdio> // std::fread, stdin
+
+#include "arguments.hpp" // app::Arguments
+#include "string_utilities.hpp" // str::split_args()
+#include "memory_mapped_file.hpp" // sys::memory_mapped_file
+#include "issues_collector.hpp" // MG::issues
+#include "parallel_tasks.hpp" // MG::run_in_parallel()
+#include "parsers_common.hpp" // parse::error
+#include "project_updater.hpp" // ll::update_project_libraries(), ll::update_projects_libraries()
+#include "project_extractor.hpp" // ll::extract_project_libraries()
+#include "libraries_converter.hpp" // ll::convert_library()
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace app
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// The jobs text contains a task per line, with the same syntax
+// of the command line (without the program name), for example:
+//   # Comment
+//   convert prog/*.h --force --to gen
+//   convert plc/*.pll --options sort --to gen/sorted
+//   wait
+//   update plc/project.ppjs
+// The jobs up to a 'wait' line are parsed and executed together using
+// the same threads; a 'wait' also stops the batch if some job failed
+class jobs_batch final
+{
+ public:
+    // What can be reused among different runs
+    struct caches_t final
+       {
+        ll::conversion_cache conversions;
+        ll::libraries_content_cache libraries_contents;
+        ll::projects_index_cache projects_indexes;
+
+        // Forget what refers to modified or removed files
+        void trim()
+           {
+            conversions.trim();
+            libraries_contents.trim();
+            projects_indexes.trim();
+           }
+       };
+
+ private:
+    struct job_t final
+       {
+        std::size_t line_num = 0u;
+        Arguments args;
+       };
+
+    struct task_t final
+       {
+        std::size_t job_idx = 0u;
+        std::uintmax_t weight = 0u; // To start the heaviest first
+        std::function<void(fnotify_t const&)> run;
+       };
+
+    std::string m_origin; // For issues
+    std::vector<std::vector<std::string>> m_lines_args; // Empty when 'wait'
+    std::vector<std::size_t> m_lines_nums;
+
+ public:
+    jobs_batch(const std::string_view jobs_text, std::string&& origin)
+      : m_origin{ std::move(origin) }
+       {
+        std::size_t line_num = 0u;
+        std::size_t i_start = 0u;
+        while( i_start<jobs_text.size() )
+           {
+            std::size_t i_end = jobs_text.find('\n', i_start);
+            if( i_end==std::string_view::npos ) i_end = jobs_text.size();
+            ++line_num;
+            std::vector<std::string> args = str::split_args( jobs_text.substr(i_start, i_end-i_start) );
+            i_start = i_end + 1u;
+
+            if( args.empty() or args.front().starts_with('#') )
+               {// Empty line or comment
+                continue;
+               }
+            else if( args.size()==1u and args.front()=="wait"sv )
+               {
+                args.clear();
+               }
+            else if( args.front()=="batch"sv )
+               {
+                throw std::invalid_argument{ std::format("[{}:{}] Nested batches are not allowed", m_origin, line_num) };
+               }
+            m_lines_args.push_back( std::move(args) );
+            m_lines_nums.push_back( line_num );
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Returns the number of failed jobs
+    [[nodiscard]] std::size_t run(const unsigned int threads_count, fnotify_t const& notify_issue, caches_t* const caches =nullptr) const
+       {
+        std::size_t failed_jobs_count = 0u;
+        std::size_t i_line = 0u;
+        while( i_line<m_lines_args.size() )
+           {
+            // Collect the jobs up to next 'wait'
+            std::size_t i_wait = i_line;
+            while( i_wait<m_lines_args.size() and not m_lines_args[i_wait].empty() ) ++i_wait;
+
+            // Parsed just now, to see the effects of the jobs before 'wait'
+            std::vector<job_t> jobs;
+            std::vector<MG::issues> jobs_issues;
+            std::vector<char> jobs_failed;
+            for( ; i_line<i_wait; ++i_line )
+               {
+                jobs.push_back( job_t{m_lines_nums[i_line], {}} );
+                jobs_issues.emplace_back();
+                jobs_failed.push_back(0);
+                try{
+                    jobs.back().args.parse( m_lines_args[i_line] );
+                   }
+                catch( std::exception& e )
+                   {
+                    jobs_issues.back()( std::format("Invalid job: {}", e.what()) );
+                    jobs_failed.back() = 1;
+                   }
+               }
+            ++i_line; // Skip 'wait'
+
+            const std::vector<task_t> tasks = prepare_tasks(jobs, jobs_issues, jobs_failed, caches);
+            run_tasks(tasks, threads_count, jobs_issues, jobs_failed);
+
+            // Report in jobs order
+            for( std::size_t i=0; i<jobs.size(); ++i )
+               {
+                for( const auto& issue : jobs_issues[i] )
+                   {
+                    notify_issue( std::format("[{}:{}] {}", m_origin, jobs[i].line_num, issue) );
+                   }
+                failed_jobs_count += jobs_failed[i]!=0 ? 1u : 0u;
+               }
+
+            if( failed_jobs_count>0u and i_line<m_lines_args.size() )
+               {
+                notify_issue( std::format("[{}:{}] Batch stopped for previous errors", m_origin, m_lines_nums[i_line-1u]) );
+                break;
+               }
+           }
+        return failed_jobs_count;
+       }
+
+ private:
+    //-----------------------------------------------------------------------
+    [[nodiscard]] static std::vector<task_t> prepare_tasks(const std::vector<job_t>& jobs, std::vector<MG::issues>& jobs_issues, std::vector<char>& jobs_failed, caches_t* const caches)
+       {
+        std::vector<task_t> tasks;
+        for( std::size_t job_idx=0; job_idx<jobs.size(); ++job_idx )
+           {
+            if( jobs_failed[job_idx] ) continue;
+            const Arguments& args = jobs[job_idx].args;
+
+            if( args.task().is_serve() or not args.socket_path().empty() )
+               {// Would block or recurse
+                jobs_issues[job_idx]("Invalid job: Can't serve or use a server in a batch");
+                jobs_failed[job_idx] = 1;
+                continue;
+               }
+            if( args.streamed() )
+               {// The batch has no streams for the jobs
+                jobs_issues[job_idx]("Invalid job: Can't stream a project in a batch");
+                jobs_failed[job_idx] = 1;
+                continue;
+               }
+
+            const auto weight_of = [](const fs::path& pth) noexcept -> std::uintmax_t
+               {
+                std::error_code ec;
+                const auto siz = fs::file_size(pth, ec);
+                return ec ? 0u : siz;
+               };
+
+            if( args.task().is_update() )
+               {
+                tasks.push_back( task_t{job_idx, weight_of(args.prj_path()), [&args, caches](fnotify_t const& notify_issue)
+                   {
+                    std::optional<ll::library_sources> library_sources;
+                    if( not args.sources_files().empty() )
+                       {
+                        library_sources.emplace(args.sources_files(), args.options());
+                       }
+                    const ll::library_sources* const sources = library_sources ? &library_sources.value() : nullptr;
+                    if( args.prj_paths().size()>1u )
+                       {
+                        ll::update_projects_libraries(args.prj_paths(), 1u, notify_issue, caches ? &caches->libraries_contents : nullptr, sources, caches ? &caches->projects_indexes : nullptr);
+                       }
+                    else
+                       {
+                        ll::update_project_libraries(args.prj_path(), args.out_path(), notify_issue, caches ? &caches->libraries_contents : nullptr, 1u, sources, caches ? &caches->projects_indexes : nullptr);
+                       }
+                   }} );
+               }
+            else if( args.task().is_extract() )
+               {
+                tasks.push_back( task_t{job_idx, weight_of(args.prj_path()), [&args](fnotify_t const& notify_issue)
+                   {
+                    ll::prepare_output_dir(args.out_path(), false, notify_issue);
+                    [[maybe_unused]] const std::size_t written_count = ll::extract_project_libraries(args.prj_path(), args.out_path(), args.overwrite_existing(), 1u, notify_issue);
+                   }} );
+               }
+            else if( args.task().is_convert() )
+               {
+                if( args.watch() )
+                   {
+                    jobs_issues[job_idx]("Can't watch in a batch");
+                    jobs_failed[job_idx] = 1;
+                   }
+                else if( args.incremental() )
+                   {
+                    tasks.push_back( task_t{job_idx, 0u, [&args](fnotify_t const& notify_issue)
+                       {
+                        fs::create_directories(args.out_path());
+                        std::optional<ll::outputs_cache> outputs_cache;
+                        if( not args.cache_dir().empty() )
+                           {
+                            outputs_cache.emplace(args.cache_dir(), args.cache_max_size(), app::build_id);
+                           }
+                        ll::convert_changed_libraries(args.input_files(), args.out_path(), args.options(), app::build_id, 1u, notify_issue, outputs_cache ? &outputs_cache.value() : nullptr);
+                       }} );
+                   }
+                else
+                   {
+                    std::shared_ptr<ll::outputs_cache> outputs_cache; // Shared by the tasks of this job
+                    try{
+                        if( args.input_files().size()>1 and args.targets().empty() )
+                           {
+                            ll::prepare_output_dir(args.out_path(), args.overwrite_existing(), std::ref(jobs_issues[job_idx]));
+                           }
+                        for( const auto& target : args.targets() )
+                           {
+                            ll::prepare_output_dir(target.output_path, args.overwrite_existing(), std::ref(jobs_issues[job_idx]));
+                           }
+                        if( not args.cache_dir().empty() )
+                           {
+                            outputs_cache = std::make_shared<ll::outputs_cache>(args.cache_dir(), args.cache_max_size(), app::build_id);
+                           }
+                       }
+                    catch( std::exception& e )
+                       {
+                        jobs_issues[job_idx]( e.what() );
+                        jobs_failed[job_idx] = 1;
+                        continue;
+                       }
+                    for( const auto& input_file_path : args.input_files() )
+                       {
+                        tasks.push_back( task_t{job_idx, weight_of(input_file_path), [&args, &input_file_path, caches, outputs_cache](fnotify_t const& notify_issue)
+                           {
+                            if( not args.targets().empty() )
+                               {
+                                ll::convert_library_to_targets(input_file_path, args.targets(), args.overwrite_existing(), notify_issue);
+                               }
+                            else if( caches )
+                               {
+                                ll::convert_library(input_file_path, args.out_path(), args.overwrite_existing(), args.options(), notify_issue, caches->conversions);
+                               }
+                            else
+                               {
+                                ll::convert_library(input_file_path, args.out_path(), args.overwrite_existing(), args.options(), notify_issue, outputs_cache.get());
+                               }
+                           }} );
+                       }
+                   }
+               }
+           }
+        return tasks;
+       }
+
+    //-----------------------------------------------------------------------
+    static void run_tasks(const std::vector<task_t>& tasks, const unsigned int threads_count, std::vector<MG::issues>& jobs_issues, std::vector<char>& jobs_failed)
+       {
+        std::vector<std::size_t> order(tasks.size());
+        for( std::size_t i=0; i<order.size(); ++i ) order[i] = i;
+        std::ranges::stable_sort(order, [&tasks](const std::size_t a, const std::size_t b) noexcept { return tasks[a].weight>tasks[b].weight; });
+
+        std::vector<MG::issues> tasks_issues(tasks.size());
+        std::vector<char> tasks_failed(tasks.size(), 0);
+        MG::run_in_parallel(order, threads_count, [&](const std::size_t idx) noexcept
+           {
+            try{
+                tasks[idx].run( std::ref(tasks_issues[idx]) );
+               }
+            catch( parse::error& e )
+               {
+                tasks_issues[idx]( std::format("[{}:{}] {}", e.file(), e.line(), e.what()) );
+                tasks_failed[idx] = 1;
+               }
+            catch( std::exception& e )
+               {
+                tasks_issues[idx]( e.what() );
+                tasks_failed[idx] = 1;
+               }
+           });
+
+        // Tasks are already in jobs order
+        for( std::size_t idx=0; idx<tasks.size(); ++idx )
+           {
+            if( tasks_failed[idx] ) jobs_failed[tasks[idx].job_idx] = 1;
+            for( const auto& issue : tasks_issues[idx] )
+               {
+                jobs_issues[tasks[idx].job_idx]( std::string(issue) );
+               }
+           }
+       }
+};
+
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::string read_jobs_text(const fs::path& jobs_path)
+{
+    std::string text;
+    if( jobs_path=="-" )
+       {
+        char buf[4096];
+        std::size_t n;
+        while( (n = std::fread(buf, 1, sizeof(buf), stdin))>0u )
+           {
+            text.append(buf, n);
+           }
+       }
+    else if( fs::file_size(jobs_path)>0u )
+       {
+        const sys::memory_mapped_file jobs_file_mapped{ jobs_path.string().c_str() };
+        text = jobs_file_mapped.as_string_view();
+       }
+    return text;
+}
+
+
+//---------------------------------------------------------------------------
+// Returns the number of failed jobs
+[[nodiscard]] std::size_t run_jobs_batch(const fs::path& jobs_path, const unsigned int threads_count, fnotify_t const& notify_issue)
+{
+    const jobs_batch batch( read_jobs_text(jobs_path), jobs_path=="-" ? std::string{"stdin"} : jobs_path.string() );
+    return batch.run(threads_count, notify_issue);
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"jobs_batch"> jobs_batch_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("app::jobs_batch") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto lib = dir.create_file("sample-lib.pll", sample_lib_pll);
+    const auto def = dir.create_file("sample-def.h", sample_def_header);
+    const fs::path out1 = dir.path() / "out1";
+    const fs::path out2 = dir.path() / "out2";
+
+    ut::should("run all the jobs") = [&]
+       {
+        const std::string jobs_text = std::format("# Comment\n"
+                                                  "\n"
+                                                  "convert \"{0}\" \"{1}\" --to \"{2}\" --options plclib-indent:2\n"
+                                                  "  convert \"{0}\" -o \"{3}\"  \r\n"
+                                                  "wait\n"
+                                                  "convert \"{2}/*.pll\" --to \"{2}/sample-def2.plclib\"\n",
+                                                  lib.path().string(), def.path().string(), out1.string(), out2.string());
+        MG::issues issues;
+        const auto failed = app::jobs_batch(jobs_text, "jobs"s).run(2u, std::ref(issues));
+        ut::expect( ut::that % failed==0u );
+        ut::expect( ut::that % issues.size()==0u );
+        ut::expect( ut::that % test::read_file_content((out1 / "sample-lib.plclib").string()) == sample_lib_plclib );
+        ut::expect( fs::exists(out1 / "sample-def.pll") );
+        ut::expect( fs::exists(out2 / "sample-lib.plclib") );
+        ut::expect( fs::exists(out1 / "sample-def2.plclib") ) << "jobs after wait should see the previous results\n";
+       };
+
+    ut::should("stop at wait after a failure") = [&]
+       {
+        const std::string jobs_text = std::format("convert \"{0}/not-existing.h\" --to \"{0}/out3\"\n"
+                                                  "convert \"{1}\" --to \"{0}/out3\"\n"
+                                                  "wait\n"
+                                                  "convert \"{1}\" --to \"{0}/out4\"\n",
+                                                  dir.path().string(), lib.path().string());
+        MG::issues issues;
+        const auto failed = app::jobs_batch(jobs_text, "jobs"s).run(2u, std::ref(issues));
+        ut::expect( ut::that % failed==1u );
+        ut::expect( ut::that % issues.size()==2u );
+        ut::expect( issues.size()==2u and issues.at(0).starts_with("[jobs:1]"sv) ) << issues.at(0) << '\n';
+        ut::expect( issues.size()==2u and issues.at(1).contains("stopped"sv) );
+        ut::expect( fs::exists(dir.path() / "out3" / "sample-lib.plclib") );
+        ut::expect( not fs::exists(dir.path() / "out4") );
+       };
+
+    ut::should("reject the jobs not executable in a batch") = [&]
+       {
+        const std::string jobs_text = std::format("serve --socket \"{0}/lltool.sock\"\n"
+                                                  "convert \"{1}\" --to \"{0}/out5\" --socket \"{0}/lltool.sock\"\n"
+                                                  "update - --to -\n",
+                                                  dir.path().string(), lib.path().string());
+        MG::issues issues;
+        const auto failed = app::jobs_batch(jobs_text, "jobs"s).run(2u, std::ref(issues));
+        ut::expect( ut::that % failed==3u );
+        ut::expect( ut::that % issues.size()==3u );
+        ut::expect( std::ranges::all_of(issues, [](const std::string& issue) noexcept { return issue.contains("Invalid job"sv); }) );
+        ut::expect( not fs::exists(dir.path() / "out5") );
+       };
+
+    ut::should("reject nested batches") = []
+       {
+        ut::expect( ut::throws([]{ app::jobs_batch("batch other.txt\n"sv, "jobs"s); }) );
+       };
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,194 @@
+#pragma once
+//  ---------------------------------------------
+//  Execute the jobs requested through a socket,
+//  keeping in memory what can be reused
+//  ---------------------------------------------
+//  #include "jobs_server.hpp" // app::serve_jobs(), app::request_jobs()
+//  ---------------------------------------------
+#include <string>
+#include <string_view>
+#include <format>
+#include <print>
+#include <chrono> // std::chrono::milliseconds
+#include <cstdio> // std::fflush
+
+#include "jobs_batch.hpp" // app::jobs_batch
+#include "local_socket.hpp" // sys::local_socket_server, sys::connect_to_local_socket()
+#include "string_conversions.hpp" // str::to_num_or<>()
+#include "filesystem_utilities.hpp" // fsu::CurrentPathLocalChanger
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace app
+{
+// Request:
+//   <working directory>
+//   <jobs text, see app::jobs_batch>
+// Response:
+//   ! <issue>
+//   ...
+//   exit: <code>
+// The request "stop" ends the server
+static constexpr std::string_view stop_request = "stop"sv;
+static constexpr std::string_view exit_prefix = "exit: "sv;
+// A client can't hold the server longer than this
+static constexpr std::chrono::milliseconds default_request_timeout = std::chrono::seconds{10};
+
+
+//---------------------------------------------------------------------------
+// Serve the requests one at a time, until a stop request.
+// After each request the caches are trimmed
+void serve_jobs(const fs::path& socket_path, const unsigned int threads_count, const bool verbose, const std::chrono::milliseconds request_timeout =default_request_timeout)
+{
+    const sys::local_socket_server server{ socket_path };
+    jobs_batch::caches_t caches;
+    if( verbose )
+       {
+        std::print("Listening on {}\n", socket_path.string());
+        std::fflush(stdout);
+       }
+
+    while( true )
+       {
+        const auto connection = server.accept_connection();
+        std::string request;
+        try{
+            request = connection.receive_message(request_timeout);
+           }
+        catch( std::exception& e )
+           {// Client stuck or gone, serve the next one
+            if( verbose ) std::print("! {}\n", e.what());
+            continue;
+           }
+        if( request==stop_request )
+           {
+            connection.send_message( std::format("{}0\n", exit_prefix) );
+            break;
+           }
+
+        std::string response;
+        int exit_code = 0;
+        try{
+            const std::size_t i_eol = request.find('\n');
+            if( i_eol==std::string::npos )
+               {
+                throw std::invalid_argument{"Malformed request"};
+               }
+            const std::string_view request_sv{request};
+            fsu::CurrentPathLocalChanger curr_path_changed( fs::path{request_sv.substr(0, i_eol)} );
+            std::size_t issues_count = 0u;
+            const std::size_t failed_jobs_count = jobs_batch(request_sv.substr(i_eol+1u), "request"s).run(threads_count, [&response, &issues_count](std::string&& issue)
+               {
+                response += std::format("! {}\n", issue);
+                ++issues_count;
+               }, &caches);
+            exit_code = failed_jobs_count>0u ? 2 : (issues_count>0u ? 1 : 0);
+           }
+        catch( std::exception& e )
+           {
+            response += std::format("! {}\n", e.what());
+            exit_code = 2;
+           }
+        response += std::format("{}{}\n", exit_prefix, exit_code);
+
+        if( verbose )
+           {
+            std::print("Served request ({} bytes), exit code {}\n", request.size(), exit_code);
+            std::fflush(stdout);
+           }
+        try{
+            connection.send_message(response);
+           }
+        catch( std::exception& e )
+           {// Client gone, not a reason to stop
+            if( verbose ) std::print("! {}\n", e.what());
+           }
+        caches.trim();
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// Send some jobs to the server, returns the exit code
+[[nodiscard]] int request_jobs(const fs::path& socket_path, const std::string_view jobs_text, fnotify_t const& notify_issue)
+{
+    const auto connection = sys::connect_to_local_socket(socket_path);
+    connection.send_message( std::format("{}\n{}", fs::current_path().string(), jobs_text) );
+    const std::string response = connection.receive_message();
+
+    std::string_view rest{response};
+    while( not rest.empty() )
+       {
+        std::size_t i_eol = rest.find('\n');
+        if( i_eol==std::string_view::npos ) i_eol = rest.size();
+        const std::string_view line = rest.substr(0, i_eol);
+        rest.remove_prefix( std::min(i_eol+1u, rest.size()) );
+
+        if( line.starts_with("! "sv) )
+           {
+            notify_issue( std::string(line.substr(2u)) );
+           }
+        else if( line.starts_with(exit_prefix) )
+           {
+            return str::to_num_or<int>(line.substr(exit_prefix.size())).value_or(2);
+           }
+       }
+    throw std::runtime_error{"Incomplete response from server"};
+}
+
+
+//---------------------------------------------------------------------------
+void request_server_stop(const fs::path& socket_path)
+{
+    const auto connection = sys::connect_to_local_socket(socket_path);
+    connection.send_message(stop_request);
+    [[maybe_unused]] const std::string response = connection.receive_message();
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"jobs_server"> jobs_server_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("app::serve_jobs()") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto lib = dir.create_file("sample-lib.pll", sample_lib_pll);
+    const fs::path socket_path = dir.path() / "lltool.sock";
+
+    std::jthread server([&socket_path]{ app::serve_jobs(socket_path, 2u, false, std::chrono::milliseconds{200}); });
+    while( not fs::exists(socket_path) ) std::this_thread::sleep_for(std::chrono::milliseconds{5});
+
+    // A client that never completes its request doesn't block the others
+    const auto stuck_client = sys::connect_to_local_socket(socket_path);
+
+    const std::string jobs_text = std::format("convert \"{}\" --force --options plclib-indent:2 --to \"{}\"\n", lib.path().string(), (dir.path() / "out").string());
+    const fs::path out_file_path = dir.path() / "out" / "sample-lib.plclib";
+       {MG::issues issues;
+        ut::expect( ut::that % app::request_jobs(socket_path, jobs_text, std::ref(issues))==0 );
+        ut::expect( ut::that % issues.size()==0u );
+        ut::expect( ut::that % test::read_file_content(out_file_path.string()) == sample_lib_plclib );
+
+        // Repeated request, the unchanged output is not written again
+        const auto time_before = fs::last_write_time(out_file_path);
+        ut::expect( ut::that % app::request_jobs(socket_path, jobs_text, std::ref(issues))==0 );
+        ut::expect( fs::last_write_time(out_file_path)==time_before );
+
+        ut::expect( ut::that % app::request_jobs(socket_path, "convert not-existing.h\n"sv, std::ref(issues))==2 );
+        ut::expect( ut::that % issues.size()==1u );
+       }
+
+    app::request_server_stop(socket_path);
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
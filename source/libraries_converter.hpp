@@ -7,6 +7,14 @@
 #include <stdexcept> // std::runtime_error
 #include <format>
 #include <string_view>
+#include <vector>
+#include <algorithm> // std::ranges::stable_sort, std::ranges::any_of
+#include <concepts> // std::invocable
+#include <memory> // std::shared_ptr
+#include <future> // std::async
+#include <mutex> // std::mutex, std::scoped_lock
+#include <unordered_map>
+#include <optional>
 #include <cassert>
 
 #include "filesystem_utilities.hpp" // fs::*, fsu::*
@@ -16,8 +24,16 @@
 #include "h_file_parser.hpp" // sipro::h_parse()
 #include "pll_file_parser.hpp" // ll::pll_parse()
 #include "file_write.hpp" // sys::file_write()
+#include "file_update.hpp" // sys::file_update
 #include "writer_pll.hpp" // pll::write_lib()
 #include "writer_plclib.hpp" // plclib::write_lib()
+#include "issues_collector.hpp" // MG::issues
+#include "parallel_tasks.hpp" // MG::run_in_parallel()
+#include "conversion_manifest.hpp" // ll::conversion_manifest
+#include "mapped_files_cache.hpp" // sys::mapped_files_cache<>
+#include "shared_files_store.hpp" // sys::shared_files_store
+#include "sha256.hpp" // MG::sha256_hasher
+#include "conversion_target.hpp" // ll::conversion_target_t
 
 using namespace std::literals; // "..."sv
 
@@ -161,6 +177,14 @@ struct outpaths_t final { fs::path pll, plclib; };
     return output_files_paths;
 }
 
+//---------------------------------------------------------------------------
+// With option "write-if-changed" the existing outputs are expected:
+// they are rewritten just if their content would change
+[[nodiscard]] bool can_overwrite_outputs(const bool can_overwrite, const MG::options_map& conv_options) noexcept
+{
+    return can_overwrite or conv_options.contains("write-if-changed");
+}
+
 
 //---------------------------------------------------------------------------
 void parse_library(plcb::Library& lib, const std::string& input_file_fullpath, const file_type input_file_type, const std::string_view input_file_bytes, const MG::options_map& conv_options, fnotify_t const& notify_issue)
@@ -199,42 +223,164 @@ void parse_library(plcb::Library& lib, const std::string& input_file_fullpath, c
 
 
 //---------------------------------------------------------------------------
-bool write_library(const plcb::Library& lib, const fs::path& out_pll, const fs::path& out, const MG::options_map& conv_options)
+// With option "write-if-changed" an existing file with the same
+// content is left untouched, preserving its modification time
+void write_output_file(const fs::path& out_path, const MG::options_map& conv_options, auto&& write_content)
 {
-    bool something_done = false;
-
-    if( not out_pll.empty() )
+    if( conv_options.contains("write-if-changed") )
        {
-        sys::file_write out_file{ out_pll.string().c_str() };
+        sys::file_update out_file{ out_path };
         out_file.set_buffer_size(4_MB);
-        pll::write_lib(out_file, lib, conv_options);
-        something_done = true;
+        write_content(out_file);
+        out_file.commit();
        }
-
-    if( not out.empty() )
+    else
        {
-        sys::file_write out_file{ out.string().c_str() };
+        sys::file_write out_file{ out_path.string().c_str() };
         out_file.set_buffer_size(4_MB);
-        plclib::write_lib(out_file, lib, conv_options);
-        something_done = true;
+        write_content(out_file);
        }
+}
+
+//---------------------------------------------------------------------------
+// When both are requested, the pll is written concurrently to the plclib:
+// the library is just read and each output has its own buffer
+bool write_library(const plcb::Library& lib, const fs::path& out_pll, const fs::path& out, const MG::options_map& conv_options)
+{
+    const auto write_pll = [&lib, &out_pll, &conv_options]()
+       {
+        write_output_file(out_pll, conv_options, [&lib, &conv_options](auto& out_file){ pll::write_lib(out_file, lib, conv_options); });
+       };
+    const auto write_plclib = [&lib, &out, &conv_options]()
+       {
+        write_output_file(out, conv_options, [&lib, &conv_options](auto& out_file){ plclib::write_lib(out_file, lib, conv_options); });
+       };
 
-    return something_done;
+    if( not out_pll.empty() and not out.empty() )
+       {
+        std::future<void> pll_written = std::async(std::launch::async, write_pll);
+        write_plclib();
+        pll_written.get(); // Possibly rethrows
+        return true;
+       }
+    else if( not out_pll.empty() )
+       {
+        write_pll();
+        return true;
+       }
+    else if( not out.empty() )
+       {
+        write_plclib();
+        return true;
+       }
+    return false;
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// The outputs of the conversions, addressed by the input content and
+// whatever else affects them, shared among workspaces and processes:
+// the address is a SHA-256 digest, two inputs can't share the outputs
+class outputs_cache final
+{
+ private:
+    sys::shared_files_store m_store;
+    std::string m_tool_id;
+
+ public:
+    outputs_cache(const fs::path& dir, const std::uintmax_t max_size, const std::string_view tool_id)
+      : m_store{ dir, max_size }
+      , m_tool_id{ tool_id }
+       {}
+
+    [[nodiscard]] sys::shared_files_store::stats_t stats() const noexcept { return m_store.stats(); }
+    void trim() { m_store.trim(); }
+
+    //-----------------------------------------------------------------------
+    // Empty if the outputs can't be reused
+    [[nodiscard]] std::string key_of(const fs::path& input_file_path, const std::string_view input_file_bytes, const fs::path& out_pll, const fs::path& out, const MG::options_map& conv_options) const
+       {
+        if( conv_options.contains("timestamp") )
+           {// Outputs differ at each run
+            return {};
+           }
+        MG::sha256_hasher hasher;
+        hasher.update(input_file_bytes);
+        // The library name is the file stem
+        hasher.update( std::format("\n{}\n{}\n{}\n{:d}{:d}", m_tool_id, conv_options.to_string(), input_file_path.filename().string(), not out_pll.empty(), not out.empty()) );
+        return MG::to_hex( hasher.digest() );
+       }
+
+    //-----------------------------------------------------------------------
+    // Returns false if not available
+    [[nodiscard]] bool retrieve(const std::string_view key, const fs::path& out_pll, const fs::path& out, const MG::options_map& conv_options)
+       {
+        const auto entry_dir = m_store.find(key);
+        if( not entry_dir.has_value() )
+           {
+            return false;
+           }
+        const auto copy_to = [&conv_options](const fs::path& cached_path, const fs::path& out_path)
+           {
+            if( fs::file_size(cached_path)==0u )
+               {// Can't be mapped
+                write_output_file(out_path, conv_options, [](auto&){});
+                return;
+               }
+            const sys::memory_mapped_file cached_mapped{ cached_path.string().c_str() };
+            write_output_file(out_path, conv_options, [&cached_mapped](auto& out_file){ out_file << cached_mapped.as_string_view(); });
+           };
+        try{
+            if( not out_pll.empty() ) copy_to(*entry_dir / "pll", out_pll);
+            if( not out.empty() ) copy_to(*entry_dir / "plclib", out);
+           }
+        catch( std::exception& )
+           {// Removed by someone else in the meantime
+            return false;
+           }
+        return true;
+       }
+
+    //-----------------------------------------------------------------------
+    void store(const std::string_view key, const fs::path& out_pll, const fs::path& out)
+       {
+        std::vector<std::pair<std::string_view,fs::path>> files;
+        if( not out_pll.empty() ) files.emplace_back("pll"sv, out_pll);
+        if( not out.empty() ) files.emplace_back("plclib"sv, out);
+        m_store.insert(key, files);
+       }
+};
+
+
 //---------------------------------------------------------------------------
-void convert_library(const fs::path& input_file_path, fs::path output_path, const bool can_overwrite, const MG::options_map& conv_options, fnotify_t const& notify_issue)
+// Given a cache, the outputs of an already seen input are just copied.
+// Conversions that raised issues are not cached, to report them again
+void convert_library(const fs::path& input_file_path, fs::path output_path, const bool can_overwrite, const MG::options_map& conv_options, fnotify_t const& notify_issue, outputs_cache* const cache =nullptr)
 {
     const std::string input_file_fullpath{ input_file_path.string() };
     const std::string input_file_basename{ input_file_path.stem().string() };
 
     const file_type input_file_type = recognize_file_type( input_file_fullpath );
-    const auto [out_pll, out] = set_output_paths(input_file_path, input_file_type, output_path, can_overwrite);
+    const auto [out_pll, out] = set_output_paths(input_file_path, input_file_type, output_path, can_overwrite_outputs(can_overwrite, conv_options));
 
-    plcb::Library lib( input_file_basename );
     const sys::memory_mapped_file input_file_mapped{ input_file_fullpath.c_str() }; // This must live until the end
-    parse_library(lib, input_file_fullpath, input_file_type, input_file_mapped.as_string_view(), conv_options, notify_issue);
+    std::string cache_key;
+    if( cache and (not out_pll.empty() or not out.empty()) )
+       {
+        cache_key = cache->key_of(input_file_path, input_file_mapped.as_string_view(), out_pll, out, conv_options);
+        if( not cache_key.empty() and cache->retrieve(cache_key, out_pll, out, conv_options) )
+           {
+            return;
+           }
+       }
+
+    plcb::Library lib( input_file_basename );
+    std::size_t issues_count = 0u;
+    parse_library(lib, input_file_fullpath, input_file_type, input_file_mapped.as_string_view(), conv_options, [&notify_issue, &issues_count](std::string&& msg)
+       {
+        ++issues_count;
+        notify_issue( std::move(msg) );
+       });
     lib.throw_if_incoherent();
 
     const bool something_done = write_library(lib, out_pll, out, conv_options);
@@ -242,6 +388,341 @@ void convert_library(const fs::path& input_file_path, fs::path output_path, cons
        {
         notify_issue( std::format("Nothing to do for: \"{}\""sv, input_file_fullpath) );
        }
+    else if( not cache_key.empty() and issues_count==0u )
+       {
+        cache->store(cache_key, out_pll, out);
+       }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Keeps the parsed libraries and the state of the written files,
+// so that repeated conversions of unchanged files cost just a check.
+// Both are limited in number, trim() drops the outdated ones
+class conversion_cache final
+{
+ public:
+    struct parsed_library_t final
+       {
+        plcb::Library lib;
+        std::vector<std::string> issues; // Notified while parsing
+       };
+    using library_entry_t = sys::mapped_files_cache<parsed_library_t>::entry_t;
+
+ private:
+    struct written_t final
+       {
+        sys::file_stamp_t stamp;
+        std::weak_ptr<const library_entry_t> source; // Not keeping alive a dropped library
+        std::string options;
+        std::uint64_t last_use = 0u;
+       };
+
+    sys::mapped_files_cache<parsed_library_t> m_libraries;
+    std::mutex m_written_mutex;
+    std::unordered_map<std::string, written_t> m_written; // By output path
+    std::uint64_t m_written_uses_count = 0u;
+    std::size_t m_max_written_count;
+
+ public:
+    explicit conversion_cache(const std::size_t max_libraries_count =sys::mapped_files_cache<parsed_library_t>::default_max_entries) noexcept
+      : m_libraries{max_libraries_count}
+      , m_max_written_count{4u * max_libraries_count} // Some outputs for each library
+       {}
+
+    //-----------------------------------------------------------------------
+    [[nodiscard]] std::shared_ptr<const library_entry_t> get_library(const fs::path& input_file_path, const file_type input_file_type, const MG::options_map& conv_options)
+       {
+        const std::string input_file_fullpath{ input_file_path.string() };
+        return m_libraries.get(input_file_path, std::format("{}|{}", input_file_fullpath, conv_options.to_string()), [&](const std::string_view bytes)
+           {
+            parsed_library_t parsed{ plcb::Library{input_file_path.stem().string()}, {} };
+            parse_library(parsed.lib, input_file_fullpath, input_file_type, bytes, conv_options, [&parsed](std::string&& msg){ parsed.issues.push_back(std::move(msg)); });
+            parsed.lib.throw_if_incoherent();
+            return parsed;
+           });
+       }
+
+    //-----------------------------------------------------------------------
+    // Was written from this library with these options and not touched since
+    [[nodiscard]] bool is_written(const fs::path& out_path, const std::shared_ptr<const library_entry_t>& source, const MG::options_map& conv_options)
+       {
+        std::error_code ec;
+        if( not fs::exists(out_path, ec) )
+           {
+            return false;
+           }
+        const sys::file_stamp_t stamp = sys::file_stamp_t::of(out_path);
+        std::scoped_lock lock(m_written_mutex);
+        const auto it = m_written.find( out_path.string() );
+        if( it!=m_written.end() and it->second.source.lock()==source and it->second.stamp==stamp and it->second.options==conv_options.to_string() )
+           {
+            it->second.last_use = ++m_written_uses_count;
+            return true;
+           }
+        return false;
+       }
+
+    //-----------------------------------------------------------------------
+    void set_written(const fs::path& out_path, const std::shared_ptr<const library_entry_t>& source, const MG::options_map& conv_options)
+       {
+        written_t written{ sys::file_stamp_t::of(out_path), source, conv_options.to_string() };
+        std::scoped_lock lock(m_written_mutex);
+        written.last_use = ++m_written_uses_count;
+        m_written.insert_or_assign( out_path.string(), std::move(written) );
+        sys::erase_least_recently_used(m_written, m_max_written_count);
+       }
+
+    //-----------------------------------------------------------------------
+    // Drop what refers to modified or removed files
+    void trim()
+       {
+        m_libraries.trim();
+        std::scoped_lock lock(m_written_mutex);
+        std::erase_if(m_written, [](const auto& item) noexcept { return item.second.source.expired() or not item.second.stamp.matches(fs::path{item.first}); });
+       }
+
+    [[nodiscard]] std::size_t libraries_count() const { return m_libraries.size(); }
+
+    [[nodiscard]] std::size_t written_count()
+       {
+        std::scoped_lock lock(m_written_mutex);
+        return m_written.size();
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// Same as above, but reusing what's possible from previous conversions
+void convert_library(const fs::path& input_file_path, fs::path output_path, const bool can_overwrite, const MG::options_map& conv_options, fnotify_t const& notify_issue, conversion_cache& cache)
+{
+    const file_type input_file_type = recognize_file_type( input_file_path.string() );
+    const auto [out_pll, out] = set_output_paths(input_file_path, input_file_type, output_path, can_overwrite_outputs(can_overwrite, conv_options));
+
+    const auto library_entry = cache.get_library(input_file_path, input_file_type, conv_options);
+    for( const auto& issue : library_entry->data().issues )
+       {
+        notify_issue( std::string(issue) );
+       }
+    const plcb::Library& lib = library_entry->data().lib;
+
+    const fs::path pll_to_write = not out_pll.empty() and not cache.is_written(out_pll, library_entry, conv_options) ? out_pll : fs::path{};
+    const fs::path plclib_to_write = not out.empty() and not cache.is_written(out, library_entry, conv_options) ? out : fs::path{};
+    write_library(lib, pll_to_write, plclib_to_write, conv_options);
+    if( not pll_to_write.empty() ) cache.set_written(pll_to_write, library_entry, conv_options);
+    if( not plclib_to_write.empty() ) cache.set_written(plclib_to_write, library_entry, conv_options);
+
+    if( out_pll.empty() and out.empty() )
+       {
+        notify_issue( std::format("Nothing to do for: \"{}\""sv, input_file_path.string()) );
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// The library is parsed once and written for each target. The option
+// "sort" modifies the library, so the targets that want it sorted get
+// a sorted copy, made once and just if the others want it as is
+void convert_library_to_targets(const fs::path& input_file_path, const std::vector<conversion_target_t>& targets, const bool can_overwrite, fnotify_t const& notify_issue)
+{
+    const std::string input_file_fullpath{ input_file_path.string() };
+    const file_type input_file_type = recognize_file_type( input_file_fullpath );
+
+    // Check all the outputs before writing something
+    std::vector<outpaths_t> targets_outpaths;
+    targets_outpaths.reserve( targets.size() );
+    for( const auto& target : targets )
+       {
+        targets_outpaths.push_back( set_output_paths(input_file_path, input_file_type, target.output_path, can_overwrite_outputs(can_overwrite, target.options)) );
+       }
+
+    plcb::Library lib( input_file_path.stem().string() );
+    const sys::memory_mapped_file input_file_mapped{ input_file_fullpath.c_str() }; // This must live until the end
+    parse_library(lib, input_file_fullpath, input_file_type, input_file_mapped.as_string_view(), MG::options_map{}, notify_issue);
+    lib.throw_if_incoherent();
+
+    const auto wants_sorted = [](const conversion_target_t& target) noexcept { return target.options.contains("sort"); };
+    std::optional<plcb::Library> sorted_lib;
+    if( std::ranges::all_of(targets, wants_sorted) )
+       {
+        lib.sort();
+       }
+    else if( std::ranges::any_of(targets, wants_sorted) )
+       {
+        sorted_lib.emplace(lib);
+        sorted_lib->sort();
+       }
+
+    for( std::size_t i=0; i<targets.size(); ++i )
+       {
+        const plcb::Library& target_lib = sorted_lib and wants_sorted(targets[i]) ? sorted_lib.value() : lib;
+        if( not write_library(target_lib, targets_outpaths[i].pll, targets_outpaths[i].plclib, targets[i].options) )
+           {
+            notify_issue( std::format("Nothing to do for: \"{}\" in \"{}\""sv, input_file_fullpath, targets[i].output_path.string()) );
+           }
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// Indexes of the given files (or a subset of them) sorted by decreasing size,
+// to not end up waiting the last big one when converting in parallel
+[[nodiscard]] std::vector<std::size_t> biggest_first(const std::vector<fs::path>& files_paths, std::vector<std::size_t> indexes)
+{
+    std::vector<std::uintmax_t> sizes(files_paths.size(), 0u);
+    for( const std::size_t idx : indexes )
+       {
+        std::error_code ec;
+        if( const auto siz = fs::file_size(files_paths[idx], ec); not ec ) sizes[idx] = siz;
+       }
+    std::ranges::stable_sort(indexes, [&sizes](const std::size_t a, const std::size_t b) noexcept { return sizes[a]>sizes[b]; });
+    return indexes;
+}
+//---------------------------------------------------------------------------
+[[nodiscard]] std::vector<std::size_t> biggest_first(const std::vector<fs::path>& files_paths)
+{
+    std::vector<std::size_t> indexes(files_paths.size());
+    for( std::size_t i=0; i<indexes.size(); ++i ) indexes[i] = i;
+    return biggest_first(files_paths, std::move(indexes));
+}
+
+
+//---------------------------------------------------------------------------
+void forward_issues_in_order(const std::vector<MG::issues>& files_issues, fnotify_t const& notify_issue)
+{
+    for( const auto& file_issues : files_issues )
+       {
+        for( const auto& issue : file_issues )
+           {
+            notify_issue( std::string(issue) );
+           }
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// Convert many files using a pool of threads. The issues are collected per
+// file and then forwarded in input order, so the report is deterministic
+template<std::invocable<const fs::path&, fnotify_t const&> F>
+void convert_in_parallel(const std::vector<fs::path>& input_files_paths, const unsigned int threads_count, fnotify_t const& notify_issue, F&& convert_one)
+{
+    const std::vector<std::size_t> order = biggest_first(input_files_paths);
+
+    std::vector<MG::issues> files_issues(input_files_paths.size());
+    const auto forward_issues = [&files_issues, &notify_issue]()
+       {
+        forward_issues_in_order(files_issues, notify_issue);
+       };
+
+    try{
+        MG::run_in_parallel(order, threads_count, [&](const std::size_t idx)
+           {
+            convert_one(input_files_paths[idx], std::ref(files_issues[idx]));
+           });
+       }
+    catch(...)
+       {
+        forward_issues();
+        throw;
+       }
+    forward_issues();
+}
+
+//---------------------------------------------------------------------------
+void convert_libraries(const std::vector<fs::path>& input_files_paths, const fs::path& output_path, const bool can_overwrite, const MG::options_map& conv_options, const unsigned int threads_count, fnotify_t const& notify_issue, outputs_cache* const cache =nullptr)
+{
+    convert_in_parallel(input_files_paths, threads_count, notify_issue, [&](const fs::path& input_file_path, fnotify_t const& notify_file_issue)
+       {
+        convert_library(input_file_path, output_path, can_overwrite, conv_options, notify_file_issue, cache);
+       });
+}
+
+//---------------------------------------------------------------------------
+void convert_libraries_to_targets(const std::vector<fs::path>& input_files_paths, const std::vector<conversion_target_t>& targets, const bool can_overwrite, const unsigned int threads_count, fnotify_t const& notify_issue)
+{
+    convert_in_parallel(input_files_paths, threads_count, notify_issue, [&](const fs::path& input_file_path, fnotify_t const& notify_file_issue)
+       {
+        convert_library_to_targets(input_file_path, targets, can_overwrite, notify_file_issue);
+       });
+}
+
+
+//---------------------------------------------------------------------------
+// Convert just the files that changed since the last run, according to
+// the manifest kept in the output directory. Files that raised issues
+// are not recorded, to be converted (and reported) again next time.
+// Returns the paths of the converted files
+std::vector<fs::path> convert_changed_libraries(const std::vector<fs::path>& input_files_paths, const fs::path& output_dir, const MG::options_map& conv_options, const std::string_view tool_id, const unsigned int threads_count, fnotify_t const& notify_issue, outputs_cache* const cache =nullptr)
+{
+    conversion_manifest manifest(output_dir, tool_id, conv_options);
+
+    const auto outputs_exist = [&output_dir](const fs::path& input_file_path) noexcept -> bool
+       {
+        try{
+            const auto [out_pll, out] = set_output_paths(input_file_path, recognize_file_type(input_file_path.string()), output_dir, true);
+            return (out_pll.empty() or fsu::exists(out_pll)) and (out.empty() or fsu::exists(out));
+           }
+        catch(...)
+           {
+            return false;
+           }
+       };
+
+    // Detect what changed
+    std::vector<conversion_manifest::check_t> checks(input_files_paths.size());
+    MG::run_in_parallel(input_files_paths.size(), threads_count, [&](const std::size_t idx)
+       {
+        checks[idx] = manifest.check(input_files_paths[idx]);
+        if( not checks[idx].changed and not outputs_exist(input_files_paths[idx]) )
+           {
+            checks[idx].changed = true;
+           }
+       });
+
+    std::vector<std::size_t> changed_indexes;
+    for( std::size_t i=0; i<checks.size(); ++i )
+       {
+        if( checks[i].changed ) changed_indexes.push_back(i);
+        else manifest.set(input_files_paths[i], checks[i].state); // Possibly refreshing the time
+       }
+
+    // Convert the changed ones
+    std::vector<MG::issues> files_issues(input_files_paths.size());
+    std::vector<char> converted(input_files_paths.size(), 0);
+    const auto record_and_report = [&]()
+       {
+        for( const std::size_t idx : changed_indexes )
+           {
+            if( converted[idx] and files_issues[idx].size()==0u )
+               {
+                manifest.set(input_files_paths[idx], checks[idx].state);
+               }
+           }
+        manifest.save();
+        forward_issues_in_order(files_issues, notify_issue);
+       };
+
+    try{
+        MG::run_in_parallel(biggest_first(input_files_paths, changed_indexes), threads_count, [&](const std::size_t idx)
+           {
+            convert_library(input_files_paths[idx], output_dir, true, conv_options, std::ref(files_issues[idx]), cache);
+            converted[idx] = 1;
+           });
+       }
+    catch(...)
+       {
+        record_and_report();
+        throw;
+       }
+    record_and_report();
+
+    std::vector<fs::path> converted_paths;
+    converted_paths.reserve( changed_indexes.size() );
+    for( const std::size_t idx : changed_indexes )
+       {
+        converted_paths.push_back( input_files_paths[idx] );
+       }
+    return converted_paths;
 }
 
 }//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -578,6 +1059,179 @@ ut::test("ll::convert_library()") = []
         ut::expect( out.exists() );
         ut::expect( ut::that % out.content() == sample_lib_plclib );
        };
+
+    ut::should("converting with write-if-changed") = []
+       {
+        test::TemporaryDirectory dir;
+        auto in = dir.create_file("sample-lib.pll", sample_lib_pll);
+        auto out = dir.create_file("sample-lib.plclib", sample_lib_plclib);
+        const auto time_before = fs::last_write_time(out.path());
+
+        issueslog_t issues;
+        ll::convert_library(in.path().string(), out.path(), true, MG::options_map{"plclib-indent:2,write-if-changed"}, std::ref(issues));
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( fs::last_write_time(out.path())==time_before ) << "unchanged file should be untouched\n";
+
+        ll::convert_library(in.path().string(), out.path(), true, MG::options_map{"plclib-indent:3,write-if-changed"}, std::ref(issues));
+        ut::expect( ut::that % out.content() != sample_lib_plclib );
+       };
+   };
+
+
+ut::test("ll::convert_libraries()") = []
+   {
+    ut::should("convert in parallel reporting issues in input order") = []
+       {
+        test::TemporaryDirectory dir;
+        std::vector<fs::path> inputs;
+        inputs.push_back( dir.create_file("~empty1.pll", "\n"sv).path() );
+        inputs.push_back( dir.create_file("sample-lib.pll", sample_lib_pll).path() );
+        inputs.push_back( dir.create_file("~empty2.pll", "\n"sv).path() );
+        inputs.push_back( dir.create_file("sample-def.h", sample_def_header).path() );
+        const fs::path out_dir = dir.path() / "out";
+        ll::prepare_output_dir(out_dir, false, [](std::string&&)noexcept{});
+
+        MG::issues issues;
+        ll::convert_libraries(inputs, out_dir, false, MG::options_map{"plclib-indent:2"}, 4u, std::ref(issues));
+        ut::expect( ut::that % issues.size()==2u ) << "two issues expected\n";
+        ut::expect( issues.at(0).contains("~empty1"sv) ) << issues.at(0) << '\n';
+        ut::expect( issues.at(1).contains("~empty2"sv) ) << issues.at(1) << '\n';
+
+        ut::expect( fs::exists(out_dir / "~empty1.plclib") );
+        ut::expect( fs::exists(out_dir / "~empty2.plclib") );
+        ut::expect( fs::exists(out_dir / "sample-def.pll") );
+        ut::expect( fs::exists(out_dir / "sample-def.plclib") );
+        ut::expect( ut::that % test::read_file_content((out_dir / "sample-lib.plclib").string()) == sample_lib_plclib );
+       };
+   };
+
+ut::test("ll::convert_library_to_targets()") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto lib = dir.create_file("sample-lib.pll", sample_lib_pll);
+    const std::vector<ll::conversion_target_t> targets =
+       {
+        {dir.path() / "plain", MG::options_map{"plclib-indent:2"}},
+        {dir.path() / "sorted", MG::options_map{"plclib-indent:2,sort"}},
+        {dir.path() / "sorted-tabs", MG::options_map{"sort"}},
+       };
+    for( const auto& target : targets ) fs::create_directories(target.output_path);
+
+    MG::issues issues;
+    ll::convert_library_to_targets(lib.path(), targets, false, std::ref(issues));
+    ut::expect( ut::that % issues.size()==0u );
+    ut::expect( ut::that % test::read_file_content((dir.path() / "plain" / "sample-lib.plclib").string()) == sample_lib_plclib );
+
+    // Same as converting separately
+    for( const auto& target : targets )
+       {
+        const fs::path separately_converted = dir.path() / std::format("{}.plclib", target.output_path.filename().string());
+        ll::convert_library(lib.path(), separately_converted, false, target.options, std::ref(issues));
+        ut::expect( test::read_file_content((target.output_path / "sample-lib.plclib").string()) == test::read_file_content(separately_converted.string()) ) << target.output_path.filename().string() << '\n';
+       }
+
+    ut::expect( ut::throws([&]{ ll::convert_library_to_targets(lib.path(), targets, false, std::ref(issues)); }) ) << "should not overwrite\n";
+   };
+
+ut::test("ll::conversion_cache") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto lib1 = dir.create_file("lib1.pll", sample_lib_pll);
+    const auto lib2 = dir.create_file("lib2.pll", sample_lib_pll);
+    ll::conversion_cache cache(1u);
+    MG::issues issues;
+
+    ll::convert_library(lib1.path(), dir.path() / "lib1.plclib", true, {}, std::ref(issues), cache);
+    ut::expect( ut::that % cache.libraries_count()==1u and cache.written_count()==1u );
+    ll::convert_library(lib2.path(), dir.path() / "lib2.plclib", true, {}, std::ref(issues), cache);
+    ut::expect( ut::that % cache.libraries_count()==1u ) << "should keep just the last library\n";
+
+    // The output of the dropped library is written again
+    const auto time_before = fs::last_write_time(dir.path() / "lib1.plclib");
+    fs::last_write_time(dir.path() / "lib1.plclib", time_before - std::chrono::seconds{10});
+    ll::convert_library(lib1.path(), dir.path() / "lib1.plclib", true, {}, std::ref(issues), cache);
+    ut::expect( fs::last_write_time(dir.path() / "lib1.plclib")!=time_before - std::chrono::seconds{10} );
+
+    fs::remove(dir.path() / "lib1.plclib");
+    cache.trim();
+    ut::expect( ut::that % cache.written_count()==0u ) << "outputs of dropped libraries or removed should be forgotten\n";
+    ut::expect( ut::that % issues.size()==0u );
+   };
+
+ut::test("ll::outputs_cache") = []
+   {
+    test::TemporaryDirectory dir;
+    const auto lib1 = dir.create_file("sample-lib.pll", sample_lib_pll);
+    ll::outputs_cache cache(dir.path() / "cache", 1024u*1024u, "test"sv);
+    const MG::options_map options{"plclib-indent:2"};
+
+    const auto convert_in = [&](const std::string_view subdir, const fs::path& input_file_path)
+       {
+        MG::issues issues;
+        ll::convert_library(input_file_path, dir.path() / subdir / "sample-lib.plclib", false, options, std::ref(issues), &cache);
+        ut::expect( ut::that % issues.size()==0u );
+        return test::read_file_content((dir.path() / subdir / "sample-lib.plclib").string());
+       };
+
+    fs::create_directories(dir.path() / "out1");
+    ut::expect( ut::that % convert_in("out1", lib1.path()) == sample_lib_plclib );
+    ut::expect( ut::that % cache.stats().misses_count==1u and cache.stats().inserts_count==1u );
+
+    // Same content and name elsewhere
+    fs::create_directories(dir.path() / "other");
+    const auto lib2 = dir.create_file("other/sample-lib.pll", sample_lib_pll);
+    fs::create_directories(dir.path() / "out2");
+    ut::expect( ut::that % convert_in("out2", lib2.path()) == sample_lib_plclib );
+    ut::expect( ut::that % cache.stats().hits_count==1u and cache.stats().inserts_count==1u );
+
+    // Different options
+    MG::issues issues;
+    ll::convert_library(lib1.path(), dir.path() / "out3.plclib", false, MG::options_map{"plclib-indent:3"}, std::ref(issues), &cache);
+    ut::expect( ut::that % cache.stats().misses_count==2u );
+   };
+
+ut::test("ll::convert_changed_libraries()") = []
+   {
+    test::TemporaryDirectory dir;
+    std::vector<fs::path> inputs;
+    inputs.push_back( dir.create_file("~empty.pll", "\n"sv).path() );
+    inputs.push_back( dir.create_file("sample-lib.pll", sample_lib_pll).path() );
+    inputs.push_back( dir.create_file("sample-def.h", sample_def_header).path() );
+    const fs::path out_dir = dir.path() / "out";
+    fs::create_directories(out_dir);
+    const MG::options_map options{"plclib-indent:2"};
+
+    ut::should("convert all at first run") = [&]
+       {
+        MG::issues issues;
+        const auto converted = ll::convert_changed_libraries(inputs, out_dir, options, "tool"sv, 2u, std::ref(issues));
+        ut::expect( ut::that % converted.size()==3u );
+        ut::expect( ut::that % issues.size()==1u ) << "one issue expected\n";
+        ut::expect( ut::that % test::read_file_content((out_dir / "sample-lib.plclib").string()) == sample_lib_plclib );
+       };
+
+    ut::should("convert again just the file with issues") = [&]
+       {
+        MG::issues issues;
+        const auto converted = ll::convert_changed_libraries(inputs, out_dir, options, "tool"sv, 2u, std::ref(issues));
+        ut::expect( ut::that % converted.size()==1u and converted.at(0)==inputs[0] );
+       };
+
+    ut::should("convert a missing output") = [&]
+       {
+        fs::remove(out_dir / "sample-def.plclib");
+        MG::issues issues;
+        const auto converted = ll::convert_changed_libraries(inputs, out_dir, options, "tool"sv, 2u, std::ref(issues));
+        ut::expect( ut::that % converted.size()==2u );
+        ut::expect( fs::exists(out_dir / "sample-def.plclib") );
+       };
+
+    ut::should("convert all with different options") = [&]
+       {
+        MG::issues issues;
+        const auto converted = ll::convert_changed_libraries(inputs, out_dir, MG::options_map{"plclib-indent:3"}, "tool"sv, 2u, std::ref(issues));
+        ut::expect( ut::that % converted.size()==3u );
+       };
    };
 
 };///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+#pragma once
+//  ---------------------------------------------
+//  Convert the libraries as soon as they change
+//  ---------------------------------------------
+//  #include "libraries_watcher.hpp" // ll::watch_and_convert_libraries()
+//  ---------------------------------------------
+#include <vector>
+#include <chrono>
+#include <stop_token> // std::stop_token
+#include <format>
+#include <algorithm> // std::ranges::any_of
+
+#include "libraries_converter.hpp" // ll::convert_library()
+#include "files_watcher.hpp" // sys::files_watcher
+#include "file_globbing.hpp" // MG::file_glob_matches()
+#include "parsers_common.hpp" // parse::error
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+//---------------------------------------------------------------------------
+// Watch the directories of the given input patterns converting each file
+// that matches them when written, created or moved in, until stop is
+// requested. The errors of a conversion are just notified
+void watch_and_convert_libraries(const std::vector<fs::path>& input_globs, const fs::path& output_path, const MG::options_map& conv_options, fnotify_t const& notify_converted, fnotify_t const& notify_issue, const std::stop_token stop_token)
+{
+    sys::files_watcher watcher;
+    for( const auto& input_glob : input_globs )
+       {
+        watcher.add_dir( input_glob.parent_path() );
+       }
+
+    while( not stop_token.stop_requested() )
+       {
+        for( const auto& file_path : watcher.wait_written_files(std::chrono::milliseconds{250}) )
+           {
+            if( std::ranges::any_of(input_globs, [&file_path](const fs::path& input_glob){ return MG::file_glob_matches(input_glob, file_path); }) )
+               {
+                try{
+                    convert_library(file_path, output_path, true, conv_options, notify_issue);
+                    notify_converted( file_path.string() );
+                   }
+                catch( parse::error& e )
+                   {
+                    notify_issue( std::format("[{}:{}] {}", e.file(), e.line(), e.what()) );
+                   }
+                catch( std::exception& e )
+                   {
+                    notify_issue( std::format("{}: {}", file_path.string(), e.what()) );
+                   }
+               }
+           }
+       }
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+#include <thread> // std::jthread
+#include <mutex> // std::mutex, std::scoped_lock
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"libraries_watcher"> libraries_watcher_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("ll::watch_and_convert_libraries()") = []
+   {
+    test::TemporaryDirectory dir;
+    const fs::path out_dir = dir.path() / "out";
+    fs::create_directories(out_dir);
+
+    std::mutex mtx;
+    std::vector<std::string> converted;
+    MG::issues issues;
+       {std::jthread watching([&](const std::stop_token stop_token)
+           {
+            ll::watch_and_convert_libraries({dir.path() / "*.pll"}, out_dir, MG::options_map{"plclib-indent:2"},
+                                            [&](std::string&& pth){ std::scoped_lock lock(mtx); converted.push_back(std::move(pth)); },
+                                            [&](std::string&& msg){ std::scoped_lock lock(mtx); issues(std::move(msg)); },
+                                            stop_token);
+           });
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        [[maybe_unused]] const auto in = dir.create_file("sample-lib.pll", sample_lib_pll);
+        [[maybe_unused]] const auto other = dir.create_file("other.txt", "abc"sv);
+        for( int i=0; i<100; ++i )
+           {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            std::scoped_lock lock(mtx);
+            if( not converted.empty() ) break;
+           }
+       } // Stop and join
+
+    ut::expect( ut::that % converted.size()==1u );
+    ut::expect( ut::that % issues.size()==0u );
+    ut::expect( ut::that % test::read_file_content((out_dir / "sample-lib.plclib").string()) == sample_lib_plclib );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
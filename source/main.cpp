@@ -1,65 +1,218 @@
 ﻿#include <stdexcept> // std::exception, std::invalid_argument
 #include <print>
+#include <cstdio> // std::setvbuf
+#include <optional>
 
 #include "arguments.hpp" // app::Arguments
 #include "issues_collector.hpp" // MG::issues
 #include "edit_text_file.hpp" // sys::edit_text_file()
 
-#include "project_updater.hpp" // ll::update_project_libraries()
+#include "project_updater.hpp" // ll::update_project_libraries(), ll::update_projects_libraries(), ll::library_sources
+#include "project_stream_updater.hpp" // ll::update_project_stream()
+#include "project_extractor.hpp" // ll::extract_project_libraries()
 #include "libraries_converter.hpp" // ll::convert_libraries()
+#include "libraries_watcher.hpp" // ll::watch_and_convert_libraries()
+#include "conversion_pipeline.hpp" // ll::convert_libraries_pipelined()
+#include "jobs_batch.hpp" // app::run_jobs_batch()
+#include "jobs_server.hpp" // app::serve_jobs(), app::request_jobs()
 
 //---------------------------------------------------------------------------
 int main( const int argc, const char* const argv[] )
 {
     app::Arguments args;
+    std::FILE* messages_stream = stdout;
     try{
         args.parse(argc, argv);
-        if( args.verbose() )
+        if( args.watch() )
+           {// Must precede any output
+            std::setvbuf(stdout, nullptr, _IOLBF, BUFSIZ); // Show the messages as they come
+           }
+        messages_stream = args.out_path()=="-" ? stderr : stdout; // Not mixed with the output
+        if( args.verbose() and messages_stream==stdout )
            {
             std::print("---- {} (build " __DATE__ ") ----\n", app::name);
            }
 
+        if( args.task().is_serve() )
+           {
+            app::serve_jobs(args.socket_path(), args.threads_count(), args.verbose());
+            return 0;
+           }
+        else if( not args.socket_path().empty() )
+           {// Let the server do the job
+            const std::string jobs_text = args.task().is_batch() ? app::read_jobs_text(args.jobs_path()) : args.job_line();
+            return app::request_jobs(args.socket_path(), jobs_text, [](std::string&& issue){ std::print("! {}\n", issue); });
+           }
+
         MG::issues issues;
-        if( args.task().is_update() )
+        std::size_t failed_jobs_count = 0u;
+        std::optional<ll::outputs_cache> outputs_cache;
+        if( args.task().is_convert() and not args.cache_dir().empty() )
            {
-            if( args.verbose() )
-               {
-                std::print("Updating project {}\n", args.prj_path().string());
-               }
-            ll::update_project_libraries(args.prj_path(), args.out_path(), std::ref(issues));
+            outputs_cache.emplace(args.cache_dir(), args.cache_max_size(), app::build_id);
            }
-        else if( args.task().is_convert() )
+        ll::outputs_cache* const cache = outputs_cache ? &outputs_cache.value() : nullptr;
+        std::optional<ll::library_sources> library_sources;
+        if( args.task().is_update() and not args.sources_files().empty() )
            {
-            if( args.input_files().size()>1 )
+            library_sources.emplace(args.sources_files(), args.options());
+           }
+        const ll::library_sources* const sources = library_sources ? &library_sources.value() : nullptr;
+        try{
+            if( args.task().is_batch() )
                {
-                ll::prepare_output_dir(args.out_path(), args.overwrite_existing(), std::ref(issues));
+                if( args.verbose() )
+                   {
+                    std::print("Running jobs of {} using {} threads\n", args.jobs_path().string(), args.threads_count());
+                   }
+                failed_jobs_count = app::run_jobs_batch(args.jobs_path(), args.threads_count(), std::ref(issues));
                }
-
-            for( const auto& input_file_path : args.input_files() )
+            else if( args.task().is_update() and args.streamed() )
+               {
+                ll::update_project_stream(args.prj_path(), args.out_path(), std::ref(issues), sources);
+               }
+            else if( args.task().is_update() and args.prj_paths().size()>1u )
+               {
+                if( args.verbose() )
+                   {
+                    std::print("Updating {} projects using {} threads\n", args.prj_paths().size(), args.threads_count());
+                   }
+                const std::size_t written_count = ll::update_projects_libraries(args.prj_paths(), args.threads_count(), std::ref(issues), nullptr, sources);
+                if( args.verbose() )
+                   {
+                    std::print("{} projects updated, {} already up to date\n", written_count, args.prj_paths().size()-written_count);
+                   }
+               }
+            else if( args.task().is_update() )
+               {
+                if( args.verbose() )
+                   {
+                    std::print("Updating project {}\n", args.prj_path().string());
+                   }
+                if( not ll::update_project_libraries(args.prj_path(), args.out_path(), std::ref(issues), nullptr, args.threads_count(), sources) and args.verbose() )
+                   {
+                    std::print("Project already up to date\n");
+                   }
+               }
+            else if( args.task().is_extract() )
+               {
+                ll::prepare_output_dir(args.out_path(), false, std::ref(issues));
+                const std::size_t written_count = ll::extract_project_libraries(args.prj_path(), args.out_path(), args.overwrite_existing(), args.threads_count(), std::ref(issues));
+                if( args.verbose() )
+                   {
+                    std::print("{} libraries extracted from {}\n", written_count, args.prj_path().string());
+                   }
+               }
+            else if( args.task().is_convert() and args.incremental() )
                {
+                fs::create_directories(args.out_path());
+                const auto converted = ll::convert_changed_libraries(args.input_files(), args.out_path(), args.options(), app::build_id, args.threads_count(), std::ref(issues), cache);
                 if( args.verbose() )
                    {
-                    std::print("Converting {}\n", input_file_path.string());
+                    for( const auto& input_file_path : converted )
+                       {
+                        std::print("Converted {}\n", input_file_path.string());
+                       }
+                    std::print("{} of {} files were changed\n", converted.size(), args.input_files().size());
+                   }
+               }
+            else if( args.task().is_convert() and not args.targets().empty() )
+               {
+                for( const auto& target : args.targets() )
+                   {
+                    ll::prepare_output_dir(target.output_path, args.overwrite_existing() and not target.options.contains("write-if-changed"), std::ref(issues)); // Unchanged outputs are kept
+                   }
+                if( args.verbose() )
+                   {
+                    std::print("Converting {} files to {} targets using {} threads\n", args.input_files().size(), args.targets().size(), args.threads_count());
+                   }
+                ll::convert_libraries_to_targets(args.input_files(), args.targets(), args.overwrite_existing(), args.threads_count(), std::ref(issues));
+               }
+            else if( args.task().is_convert() )
+               {
+                if( args.converts_many_files() or (args.watch() and fs::is_directory(args.out_path())) )
+                   {// Otherwise the output can be a file
+                    ll::prepare_output_dir(args.out_path(), args.overwrite_existing() and not args.options().contains("write-if-changed"), std::ref(issues)); // Unchanged outputs are kept
+                   }
+
+                if( args.pipeline() )
+                   {
+                    const auto stats = ll::convert_libraries_pipelined(args.input_files(), args.out_path(), args.overwrite_existing(), args.options(), 2u, std::ref(issues));
+                    if( args.verbose() )
+                       {
+                        std::print("{}", stats.to_string());
+                       }
+                   }
+                else if( args.threads_count()>1u and args.input_files().size()>1 )
+                   {
+                    if( args.verbose() )
+                       {
+                        std::print("Converting {} files using {} threads\n", args.input_files().size(), args.threads_count());
+                       }
+                    ll::convert_libraries(args.input_files(), args.out_path(), args.overwrite_existing(), args.options(), args.threads_count(), std::ref(issues), cache);
+                   }
+                else
+                   {
+                    for( const auto& input_file_path : args.input_files() )
+                       {
+                        if( args.verbose() )
+                           {
+                            std::print("Converting {}\n", input_file_path.string());
+                           }
+                        ll::convert_library(input_file_path, args.out_path(), args.overwrite_existing(), args.options(), std::ref(issues), cache);
+                       }
                    }
-                ll::convert_library(input_file_path, args.out_path(), args.overwrite_existing(), args.options(), std::ref(issues));
                }
            }
+        // When watching, the files will be converted again once fixed
+        catch( parse::error& e )
+           {
+            if( not args.watch() ) throw;
+            issues( std::format("[{}:{}] {}", e.file(), e.line(), e.what()) );
+           }
+        catch( std::exception& e )
+           {
+            if( not args.watch() ) throw;
+            issues( std::string{e.what()} );
+           }
 
-        if( issues.size()>0 )
+        if( outputs_cache )
            {
-            for( const auto& issue : issues )
+            outputs_cache->trim();
+            if( args.verbose() )
                {
-                std::print("! {}\n", issue);
+                const auto stats = outputs_cache->stats();
+                std::print("Cache {}: {} hits, {} misses, {} stored\n", args.cache_dir().string(), stats.hits_count, stats.misses_count, stats.inserts_count);
                }
-            return 1;
            }
 
-        return 0;
+        for( const auto& issue : issues )
+           {
+            std::print(messages_stream, "! {}\n", issue);
+           }
+
+        if( args.watch() )
+           {
+            if( args.verbose() )
+               {
+                std::print("Watching for changes (Ctrl+C to exit)\n");
+               }
+            ll::watch_and_convert_libraries(args.input_globs(), args.out_path(), args.options(),
+                                            [&args](std::string&& pth){ if(args.verbose()) std::print("Converted {}\n", pth); },
+                                            [](std::string&& issue){ std::print("! {}\n", issue); },
+                                            std::stop_token{});
+           }
+
+        if( failed_jobs_count>0u )
+           {
+            return 2;
+           }
+        return issues.size()>0 ? 1 : 0;
        }
 
     catch( std::invalid_argument& e )
        {
-        std::print("!! {}\n", e.what());
+        std::print(messages_stream, "!! {}\n", e.what());
         if( not args.quiet() )
            {
             args.print_usage();
@@ -68,8 +221,8 @@ int main( const int argc, const char* const argv[] )
 
     catch( parse::error& e)
        {
-        std::print("!! [{}:{}] {}\n", e.file(), e.line(), e.what());
-        if( not args.quiet() )
+        std::print(messages_stream, "!! [{}:{}] {}\n", e.file(), e.line(), e.what());
+        if( not args.quiet() and e.file()!="stdin" ) // A streamed input can't be edited
            {
             sys::edit_text_file( e.file(), e.line() );
            }
@@ -77,7 +230,7 @@ int main( const int argc, const char* const argv[] )
 
     catch( std::exception& e )
        {
-        std::print("!! {}\n", e.what());
+        std::print(messages_stream, "!! {}\n", e.what());
        }
 
     return 2;
@@ -0,0 +1,309 @@
+#pragma once
+//  ---------------------------------------------
+//  Extracts the libraries embedded in a
+//  LogicLab project back into files
+//  ---------------------------------------------
+//  #include "project_extractor.hpp" // ll::extract_project_libraries()
+//  ---------------------------------------------
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <numeric> // std::iota
+#include <algorithm> // std::ranges::stable_sort, std::ranges::contains
+#include <atomic>
+
+#include "project_updater.hpp" // ll::libraries_tag_name, ll::library_tag_name, ll::library_type
+#include "writer_plclib.hpp" // plclib::SchemaVersion
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// A library as found in the project, linked or not
+struct embedded_lib_t final
+   {
+    std::string name; // As in the 'name' attribute
+    library_type type = library_type::unknown;
+    std::size_t chunk_start = 0u;
+    std::size_t chunk_end = 0u;
+    std::size_t line = 0u; // Of the <lib> tag, for issues
+   };
+using embedded_libs_t = std::vector<embedded_lib_t>;
+
+
+//---------------------------------------------------------------------------
+template<utxt::Enc ENC>
+[[nodiscard]] embedded_libs_t collect_embedded_libs(const std::string_view bytes, std::string&& file_path, fnotify_t const& notify_issue)
+{
+    embedded_libs_t libs;
+
+    text::xml::Parser<ENC> parser{bytes};
+    parser.set_on_notify_issue(notify_issue);
+    parser.set_file_path( std::move(file_path) );
+    parser.options().set_collect_comment_text(false);
+    parser.options().set_collect_text_sections(false);
+
+    if constexpr( ENC==utxt::Enc::UTF8 )
+       {// Can skip the bulk without decoding it
+        if( const auto libraries_pos = text::xml::find_open_tag(bytes, libraries_tag_name_utf8); libraries_pos.has_value() )
+           {
+            parser.jump_to(libraries_pos->byte_offset, libraries_pos->line);
+           }
+       }
+    seek_libraries_tag(parser);
+    const encoded_names_t<ENC>& names = encoded_names<ENC>();
+    const auto& event = parser.curr_event_view();
+
+    while( parser.next_event_view() and not event.is_close_tag(names.libraries_tag) )
+       {
+        if( not event.is_open_tag(names.library_tag) )
+           {
+            continue;
+           }
+
+        embedded_lib_t lib;
+        lib.line = parser.curr_line();
+        if( const auto name = event.find_attribute(names.name_attr); name and name->value.has_value() )
+           {
+            const std::u32string name_value = utxt::to_utf32<ENC>(name->value.value());
+            lib.name = utxt::to_utf8(name_value);
+            lib.type = recognize_library_type(name_value);
+           }
+
+        const bool is_empty = parser.is_empty_element();
+        parser.skip_any_space();
+        lib.chunk_start = parser.curr_codepoint_byte_offset();
+        parser.skip_current_element(true);
+        lib.chunk_end = is_empty ? lib.chunk_start : event.start_byte_offset();
+
+        if( lib.name.empty() )
+           {
+            parser.notify_issue("Skipping unnamed library (expected name=\"...\")"sv);
+           }
+        else if( lib.type==library_type::unknown )
+           {
+            parser.notify_issue( std::format("Skipping unrecognized library (name=\"{}\")"sv, lib.name) );
+           }
+        else
+           {
+            libs.push_back( std::move(lib) );
+           }
+       }
+
+    if( libs.empty() )
+       {
+        notify_issue("No libraries found");
+       }
+
+    return libs;
+}
+//---------------------------------------------------------------------------
+[[nodiscard]] embedded_libs_t collect_embedded_libs(const std::string_view bytes, const utxt::Enc bytes_enc, std::string&& file_path, fnotify_t const& notify_issue)
+{
+    TEXT_DISPATCH_TO_ENC(bytes_enc, collect_embedded_libs<, >(bytes, std::move(file_path), notify_issue))
+}
+
+
+//---------------------------------------------------------------------------
+// The content of the CDATA section that a pll is wrapped in, that must
+// be the whole chunk apart trailing spaces (as written by the update)
+template<utxt::Enc ENC>
+[[nodiscard]] std::optional<std::string_view> get_cdata_content(std::string_view chunk)
+{
+    const std::string head = utxt::encode_as<ENC>(U"<![CDATA["sv);
+    const std::string tail = utxt::encode_as<ENC>(U"]]>"sv);
+    const std::size_t unit_size = tail.size() / 3u;
+    while( chunk.size()>=unit_size )
+       {
+        std::size_t pos = chunk.size() - unit_size;
+        const char32_t c = utxt::extract_codepoint<ENC>(chunk, pos);
+        if( c!=U' ' and c!=U'\t' and c!=U'\r' and c!=U'\n' ) break;
+        chunk.remove_suffix(unit_size);
+       }
+
+    std::optional<std::string_view> content;
+    if( chunk.size()>=head.size()+tail.size() and chunk.starts_with(head) and chunk.ends_with(tail) )
+       {
+        content = chunk.substr(head.size(), chunk.size()-head.size()-tail.size());
+       }
+    return content;
+}
+//---------------------------------------------------------------------------
+[[nodiscard]] std::optional<std::string_view> get_cdata_content(const std::string_view chunk, const utxt::Enc chunk_enc)
+{
+    TEXT_DISPATCH_TO_ENC(chunk_enc, get_cdata_content<, >(chunk))
+}
+
+
+//---------------------------------------------------------------------------
+// The library files are UTF-8: the content of UTF-8 projects is written
+// as is, copied kernel side from the project file when possible.
+// Returns false if the library was skipped
+bool write_embedded_lib(const fs::path& output_file_path, const embedded_lib_t& lib, const fs::path& project_file_path, const std::string_view project_bytes, const utxt::Enc project_bytes_enc, fnotify_t const& notify_issue)
+{
+    std::string_view content = project_bytes.substr(lib.chunk_start, lib.chunk_end-lib.chunk_start);
+    if( lib.type==library_type::pll )
+       {
+        const auto cdata_content = get_cdata_content(content, project_bytes_enc);
+        if( not cdata_content.has_value() )
+           {
+            notify_issue( std::format("[{}:{}] Skipping library not in a CDATA section (name=\"{}\")", project_file_path.string(), lib.line, lib.name) );
+            return false;
+           }
+        content = cdata_content.value();
+       }
+
+    std::string reencoded_buf;
+    const auto reencode = [&]() -> std::string_view { TEXT_DISPATCH_TO_ENC(project_bytes_enc, utxt::reencode_if_necessary<, ,utxt::Enc::UTF8>(content, reencoded_buf)) };
+    const std::string_view utf8_content = reencode();
+
+    sys::file_write out_file{ output_file_path.string().c_str() };
+    if( lib.type==library_type::plclib )
+       {// Wrapping the content of <lib> as plclib::write_lib() does
+        out_file << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"sv
+                 << "<plcLibrary schemaVersion=\""sv << plclib::SchemaVersion{}.string() << "\">\n"sv
+                 << "\t<lib version=\"1.0.0\" name=\""sv << output_file_path.stem().string() << "\" fullXml=\"true\">\n\t\t"sv;
+       }
+
+    if( utf8_content.data()==content.data() )
+       {
+        const sys::file_range_source project_file{ project_file_path.string().c_str() };
+        project_file.append_to(out_file, static_cast<std::uint64_t>(content.data() - project_bytes.data()), content);
+       }
+    else
+       {
+        out_file << utf8_content;
+       }
+
+    if( lib.type==library_type::plclib )
+       {
+        out_file << "</lib>\n"sv
+                 << "</plcLibrary>\n"sv;
+       }
+    return true;
+}
+
+
+//---------------------------------------------------------------------------
+// The reverse of the update: each library embedded in the project is
+// written in the output directory, named as its 'name' attribute.
+// The biggest libraries are written first by the threads, the issues
+// are forwarded in project order. Returns the number of written files
+std::size_t extract_project_libraries(const fs::path& project_file_path, const fs::path& output_dir, const bool can_overwrite, const unsigned int threads_count, fnotify_t const& notify_issue)
+{
+    const sys::memory_mapped_file project_file_mapped{ project_file_path.string().c_str() };
+    const std::string_view project_file_bytes{ project_file_mapped.as_string_view() };
+    if( project_file_bytes.empty() )
+       {
+        throw std::runtime_error{"No data to parse (empty file?)"};
+       }
+    const auto [project_bytes_enc, bom_size] = utxt::detect_encoding_of(project_file_bytes);
+
+    const embedded_libs_t libs = collect_embedded_libs(project_file_bytes, project_bytes_enc, project_file_path.string(), notify_issue);
+
+    // Checking the outputs before writing anything
+    std::vector<fs::path> output_files_paths;
+    output_files_paths.reserve( libs.size() );
+    for( const auto& lib : libs )
+       {
+        fs::path output_file_path = output_dir / fs::path{lib.name}.filename();
+        if( std::ranges::contains(output_files_paths, output_file_path) )
+           {
+            throw std::runtime_error{ std::format("Two or more libraries would be extracted in \"{}\"", output_file_path.string()) };
+           }
+        if( fs::exists(output_file_path) and not can_overwrite )
+           {
+            throw std::runtime_error{ std::format("Won't overwrite existing file \"{}\" (unless you --force me)", output_file_path.string()) };
+           }
+        output_files_paths.push_back( std::move(output_file_path) );
+       }
+
+    std::vector<std::size_t> order(libs.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::ranges::stable_sort(order, [&libs](const std::size_t a, const std::size_t b) noexcept
+       {
+        return libs[a].chunk_end-libs[a].chunk_start > libs[b].chunk_end-libs[b].chunk_start;
+       });
+
+    std::vector<MG::issues> libs_issues(libs.size());
+    std::atomic<std::size_t> written_count{0u};
+    try{
+        MG::run_in_parallel(order, threads_count, [&](const std::size_t idx)
+           {
+            if( write_embedded_lib(output_files_paths[idx], libs[idx], project_file_path, project_file_bytes, project_bytes_enc, std::ref(libs_issues[idx])) )
+               {
+                ++written_count;
+               }
+           });
+       }
+    catch(...)
+       {
+        forward_issues_in_order(libs_issues, notify_issue);
+        throw;
+       }
+    forward_issues_in_order(libs_issues, notify_issue);
+
+    return written_count.load();
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"project_extractor"> project_extractor_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("ll::extract_project_libraries()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    fs::create_directory(tmp_dir.path() / "libs");
+    const auto pll_file = tmp_dir.create_file("libs/sample-lib.pll", sample_lib_pll);
+    const auto plclib_file = tmp_dir.create_file("libs/sample-lib2.plclib", sample_lib_plclib);
+    const auto prj_file = tmp_dir.create_file("prj.ppjs",
+        "﻿"
+        "<plcProject>\n"
+        "    <libraries>\n"
+        "        <lib link=\"true\" name=\"libs/sample-lib.pll\"></lib>\n"
+        "        <lib link=\"true\" name=\"libs/sample-lib2.plclib\"></lib>\n"
+        "        <lib link=\"false\" name=\"unlinked.pll\"> <![CDATA[abc]]>\n </lib>\n"
+        "        <lib link=\"false\" name=\"bad.pll\">abc</lib>\n"
+        "    </libraries>\n"
+        "</plcProject>\n"sv);
+    ll::update_project_libraries(prj_file.path(), {}, [](std::string&&)noexcept{});
+
+    const fs::path out_dir = tmp_dir.path() / "out";
+    fs::create_directory(out_dir);
+    MG::issues issues;
+    ut::expect( ut::that % ll::extract_project_libraries(prj_file.path(), out_dir, false, 4u, std::ref(issues))==3u );
+    ut::expect( ut::that % issues.size()==1u ) << "one issue expected\n";
+    ut::expect( issues.size()==1u and issues.at(0).contains("bad.pll"sv) );
+    ut::expect( ut::that % test::read_file_content((out_dir / "sample-lib.pll").string())==sample_lib_pll );
+    ut::expect( ut::that % test::read_file_content((out_dir / "unlinked.pll").string())=="abc"sv );
+    ut::expect( not fs::exists(out_dir / "bad.pll") );
+
+    // Same content, so updating from the extracted gives the same project
+    const std::string prj_content = prj_file.content();
+    fs::copy_file(out_dir / "sample-lib2.plclib", plclib_file.path(), fs::copy_options::overwrite_existing);
+    ll::update_project_libraries(prj_file.path(), {}, [](std::string&&)noexcept{});
+    ut::expect( prj_file.content()==prj_content );
+
+    ut::expect( ut::throws([&]{ [[maybe_unused]] const auto n = ll::extract_project_libraries(prj_file.path(), out_dir, false, 1u, [](std::string&&)noexcept{}); }) ) << "should not overwrite\n";
+    ut::expect( ut::that % ll::extract_project_libraries(prj_file.path(), out_dir, true, 1u, [](std::string&&)noexcept{})==3u );
+
+    const auto utf16_prj = tmp_dir.create_file("utf16.ppjs", utxt::encode_as<utxt::Enc::UTF16LE>(U"﻿<plcProject><libraries><lib name=\"x.pll\"><![CDATA[àbc]]></lib></libraries></plcProject>"sv));
+    ut::expect( ut::that % ll::extract_project_libraries(utf16_prj.path(), out_dir, true, 1u, [](std::string&&)noexcept{})==1u );
+    ut::expect( ut::that % test::read_file_content((out_dir / "x.pll").string())=="àbc"sv );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
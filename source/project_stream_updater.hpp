@@ -0,0 +1,396 @@
+#pragma once
+//  ---------------------------------------------
+//  Updates the libraries of a LogicLab project
+//  streamed from an input to an output, keeping
+//  in memory just a window of the project bytes
+//  ---------------------------------------------
+//  #include "project_stream_updater.hpp" // ll::update_project_stream()
+//  ---------------------------------------------
+#include <cstdio> // std::FILE, std::fopen
+#include <concepts> // std::predicate
+#include <stdexcept> // std::runtime_error
+#include <format>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <memory> // std::unique_ptr
+#include <algorithm> // std::ranges::count
+
+#include "project_updater.hpp" // ll::check_linked_lib(), ll::prepare_library(), ll::insert_library()
+#include "file_write.hpp" // sys::file_write
+#include "chunked_input.hpp" // sys::chunked_input
+#include "ascii_predicates.hpp" // ascii::is_space()
+
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+namespace ll
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// A window over the bytes read from a stream: the consumed bytes are
+// copied to the output or dropped, and then forgotten when reading more.
+// The markups are recognized on the raw bytes, so just for UTF-8
+class project_stream_window final
+{
+ private:
+    sys::chunked_input m_input;
+    const sys::file_write& m_output;
+    std::size_t m_offset = 0u; // Of the first not consumed byte
+    std::size_t m_line = 1u; // Of the first not consumed byte
+    static constexpr std::size_t markup_lookahead = 16u; // Enough to recognize the markups of interest
+
+ public:
+    project_stream_window(std::FILE* const input, const sys::file_write& output) noexcept
+      : m_input{sys::chunked_input::from_stream(input)}
+      , m_output{output}
+       {}
+
+    [[nodiscard]] std::string_view view() const noexcept { return m_input.bytes().substr(m_offset - m_input.base_offset()); }
+    [[nodiscard]] std::size_t curr_line() const noexcept { return m_line; }
+
+    //-----------------------------------------------------------------------
+    // Returns false if there's nothing more to read
+    [[nodiscard]] bool read_more()
+       {
+        return m_input.read_more(m_offset); // The consumed bytes are no more needed
+       }
+
+    //-----------------------------------------------------------------------
+    // Returns false if less bytes are available
+    bool ensure(const std::size_t bytes_count)
+       {
+        while( view().size()<bytes_count )
+           {
+            if( not read_more() ) return false;
+           }
+        return true;
+       }
+
+    //-----------------------------------------------------------------------
+    void pass(const std::size_t bytes_count, const bool copying)
+       {
+        const std::string_view bytes = view().substr(0, bytes_count);
+        if( copying )
+           {
+            m_output << bytes;
+           }
+        m_line += static_cast<std::size_t>(std::ranges::count(bytes, '\n'));
+        m_offset += bytes.size();
+       }
+
+    //-----------------------------------------------------------------------
+    void pass_rest(const bool copying)
+       {
+        do {
+            pass(view().size(), copying);
+           }
+        while( read_more() );
+       }
+
+    //-----------------------------------------------------------------------
+    // Pass the spaces at the start of the view
+    void pass_spaces(const bool copying)
+       {
+        while( true )
+           {
+            const std::string_view bytes = view();
+            std::size_t i = 0u;
+            while( i<bytes.size() and ascii::is_space(bytes[i]) ) ++i;
+            pass(i, copying);
+            if( i<bytes.size() or not read_more() ) return;
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Pass the bytes up to and including 'end_mark'
+    void pass_through(const std::string_view end_mark, const bool copying, const std::string_view what)
+       {
+        const std::size_t start_line = m_line;
+        while( true )
+           {
+            if( const std::size_t i_mark = view().find(end_mark); i_mark!=std::string_view::npos )
+               {
+                pass(i_mark + end_mark.size(), copying);
+                return;
+               }
+            // Keeping what could be the start of the mark
+            pass(view().size()>=end_mark.size() ? view().size()-(end_mark.size()-1u) : 0u, copying);
+            if( not read_more() )
+               {
+                throw std::runtime_error{ std::format("Unclosed {} (line {})", what, start_line) };
+               }
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // Pass the bytes until a markup accepted by 'is_target' (called with
+    // the bytes following '<'), skipping comments, CDATA sections and
+    // processing instructions. Returns false if not found
+    template<std::predicate<const std::string_view> F>
+    [[nodiscard]] bool pass_until_markup(const bool copying, F&& is_target)
+       {
+        while( true )
+           {
+            const std::size_t i_markup = view().find('<');
+            if( i_markup==std::string_view::npos )
+               {
+                pass(view().size(), copying);
+                if( not read_more() ) return false;
+                continue;
+               }
+            pass(i_markup, copying);
+            ensure(markup_lookahead);
+
+            const std::string_view markup = view().substr(1u);
+            if( markup.starts_with("!--"sv) )
+               {
+                pass(4u, copying);
+                pass_through("-->"sv, copying, "comment"sv);
+               }
+            else if( markup.starts_with("![CDATA["sv) )
+               {
+                pass(9u, copying);
+                pass_through("]]>"sv, copying, "CDATA section"sv);
+               }
+            else if( markup.starts_with('?') )
+               {
+                pass(2u, copying);
+                pass_through("?>"sv, copying, "processing instruction"sv);
+               }
+            else if( is_target(markup) )
+               {
+                return true;
+               }
+            else
+               {
+                pass(1u, copying);
+               }
+           }
+       }
+
+    //-----------------------------------------------------------------------
+    // The size of the tag at the start of the view,
+    // up to the first '>' not in a quoted value
+    [[nodiscard]] std::size_t tag_size()
+       {
+        const std::size_t start_line = m_line;
+        char quote = '\0';
+        std::size_t i = 1u;
+        while( true )
+           {
+            const std::string_view bytes = view();
+            for( ; i<bytes.size(); ++i )
+               {
+                if( quote!='\0' )
+                   {
+                    if( bytes[i]==quote ) quote = '\0';
+                   }
+                else if( bytes[i]=='\"' or bytes[i]=='\'' )
+                   {
+                    quote = bytes[i];
+                   }
+                else if( bytes[i]=='>' )
+                   {
+                    return i+1u;
+                   }
+               }
+            if( not read_more() )
+               {
+                throw std::runtime_error{ std::format("Unclosed tag (line {})", start_line) };
+               }
+           }
+       }
+};
+
+
+//---------------------------------------------------------------------------
+// The libraries are resolved relative to 'base_dir' and inserted as they
+// are met: in memory there are just the window and the current library
+void update_project_stream(std::FILE* const input, std::string&& input_name, sys::file_write& output, const fs::path& base_dir, fnotify_t const& notify_issue, libraries_content_cache* const cache =nullptr, const library_sources* const sources =nullptr)
+{
+    project_stream_window window(input, output);
+    if( not window.ensure(4u) and window.view().empty() )
+       {
+        throw std::runtime_error{"No data to parse (empty input?)"};
+       }
+    if( utxt::detect_encoding_of(window.view()).enc!=utxt::Enc::UTF8 )
+       {
+        throw std::runtime_error{"A streamed project must be UTF-8 encoded"};
+       }
+
+    if( not window.pass_until_markup(true, [](const std::string_view markup) noexcept { return text::xml::starts_with_tag_name(markup, libraries_tag_name_utf8); }) )
+       {
+        throw std::runtime_error{ std::format("Invalid project (<{}> not found)", libraries_tag_name_utf8) };
+       }
+    window.pass(window.tag_size(), true);
+
+    std::size_t libs_count = 0u;
+    while( true )
+       {
+        bool libraries_closed = false;
+        const bool lib_found = window.pass_until_markup(true, [&libraries_closed](const std::string_view markup) noexcept
+           {
+            libraries_closed = markup.starts_with('/') and text::xml::starts_with_tag_name(markup.substr(1u), libraries_tag_name_utf8);
+            return libraries_closed or text::xml::starts_with_tag_name(markup, library_tag_name_utf8);
+           });
+        if( not lib_found )
+           {
+            throw std::runtime_error{ std::format("Invalid project (unclosed <{}>)", libraries_tag_name_utf8) };
+           }
+        if( libraries_closed )
+           {
+            break;
+           }
+
+        const std::size_t tag_size = window.tag_size();
+        const std::string_view tag = window.view().substr(0, tag_size);
+        std::optional<lib_t> lib;
+        if( not tag.ends_with("/>"sv) )
+           {// The same checks of the whole project parsing
+            text::xml::Parser<utxt::Enc::UTF8> parser{tag};
+            parser.set_on_notify_issue(notify_issue);
+            parser.set_file_path( std::string(input_name) );
+            parser.jump_to(0u, window.curr_line());
+            parser.next_event_view();
+            lib = check_linked_lib(parser, base_dir, sources);
+           }
+        window.pass(tag_size, true);
+
+        if( lib.has_value() )
+           {// The previous content is dropped, except the leading spaces as in the whole file update
+            window.pass_spaces(true);
+            const bool lib_closed = window.pass_until_markup(false, [](const std::string_view markup) noexcept
+               {
+                return markup.starts_with('/') and text::xml::starts_with_tag_name(markup.substr(1u), library_tag_name_utf8);
+               });
+            if( not lib_closed )
+               {
+                throw std::runtime_error{ std::format("Invalid project (unclosed <{}>)", library_tag_name_utf8) };
+               }
+            insert_library(lib.value(), *prepare_library(lib.value(), utxt::Enc::UTF8, cache), output);
+            ++libs_count;
+           }
+        // Otherwise the content is copied as is
+       }
+
+    window.pass_rest(true);
+
+    if( libs_count==0u )
+       {
+        notify_issue("No libraries found");
+       }
+    if( sources )
+       {
+        sources->forward_issues(notify_issue);
+       }
+}
+
+
+//---------------------------------------------------------------------------
+// "-" for stdin and stdout. Libraries are relative to the current path
+// when reading from stdin
+void update_project_stream(const fs::path& input_path, const fs::path& output_path, fnotify_t const& notify_issue, const library_sources* const sources =nullptr)
+{
+    using file_ptr = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+    file_ptr input_file{nullptr, &std::fclose};
+    std::FILE* input = stdin;
+    fs::path base_dir = fs::current_path();
+    if( input_path!="-" )
+       {
+        input_file.reset( std::fopen(input_path.string().c_str(), "rb") );
+        if( not input_file )
+           {
+            throw std::runtime_error{ std::format("Cannot read \"{}\"", input_path.string()) };
+           }
+        input = input_file.get();
+        base_dir = fs::absolute(input_path).parent_path();
+       }
+
+    sys::file_write output = output_path=="-" ? sys::file_write::to_stream(stdout) : sys::file_write{ output_path.string().c_str() };
+    output.set_buffer_size(4_MB);
+    update_project_stream(input, input_path=="-" ? "stdin"s : input_path.string(), output, base_dir, notify_issue, nullptr, sources);
+}
+
+}//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+#ifdef TEST_UNITS ///////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static ut::suite<"project_stream_updater"> project_stream_updater_tests = []
+{////////////////////////////////////////////////////////////////////////////
+
+ut::test("ll::update_project_stream()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    tmp_dir.create_file("pll1.pll", "abc");
+    const std::string big_text(700u*1024u, 'x'); // More than a window chunk
+    tmp_dir.create_file("big.plclib", std::format("<plcLibrary><lib>{}</lib></plcLibrary>", big_text));
+    const std::string prj_head = std::format(
+        "﻿<plcProject>\n"
+        "<!-- <libraries> {} -->\n"
+        "<code><![CDATA[ <libraries> ]]></code>\n"
+        "<libraries>\n", big_text);
+    const auto prj_file = tmp_dir.create_file("prj.ppjs", std::format(
+        "{}"
+        "<lib link=\"true\" name=\"pll1.pll\"><![CDATA[prev</lib>]]></lib>\n"
+        "<lib link=\"false\" name=\"pll1.pll\">kept</lib>\n"
+        "<lib link=\"true\" name=\"big.plclib\"><!-- </lib> -->{}</lib>\n"
+        "</libraries>\n"
+        "</plcProject>\n", prj_head, big_text));
+    const std::string expected = std::format(
+        "{}"
+        "<lib link=\"true\" name=\"pll1.pll\"><![CDATA[abc]]></lib>\n"
+        "<lib link=\"false\" name=\"pll1.pll\">kept</lib>\n"
+        "<lib link=\"true\" name=\"big.plclib\">{}</lib>\n"
+        "</libraries>\n"
+        "</plcProject>\n", prj_head, big_text);
+    const fs::path out_path = tmp_dir.path() / "out.ppjs";
+
+    MG::issues issues;
+    ll::update_project_stream(prj_file.path(), out_path, std::ref(issues));
+    ut::expect( ut::that % issues.size()==1u ) << "one issue expected\n";
+    ut::expect( issues.size()==1u and issues.at(0).contains(":6]"sv) ) << "line should be counted\n";
+    ut::expect( test::read_file_content(out_path.string())==expected );
+
+    // Same result of the whole file update
+    ll::update_project_libraries(prj_file.path(), {}, [](std::string&&)noexcept{});
+    ut::expect( prj_file.content()==expected );
+
+    const auto bad_prj = tmp_dir.create_file("bad.ppjs", "<plcProject><libraries><lib link=\"true\" name=\"pll1.pll\">"sv);
+    ut::expect( ut::throws([&]{ ll::update_project_stream(bad_prj.path(), out_path, [](std::string&&)noexcept{}); }) ) << "unclosed lib\n";
+    const auto utf16_prj = tmp_dir.create_file("utf16.ppjs", "\xFF\xFE<\0p\0>\0"sv);
+    ut::expect( ut::throws([&]{ ll::update_project_stream(utf16_prj.path(), out_path, [](std::string&&)noexcept{}); }) ) << "not UTF-8\n";
+   };
+
+ut::test("ll::update_project_stream() indented content") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    tmp_dir.create_file("pll1.pll", "abc");
+    tmp_dir.create_file("pll2.pll", "def\nghi");
+    const auto prj_file = tmp_dir.create_file("prj.ppjs",
+        "<plcProject>\n"
+        "  <libraries>\n"
+        "    <lib link=\"true\" name=\"pll1.pll\">\n"
+        "       <![CDATA[prev]]>\n"
+        "    </lib>\n"
+        "    <lib link=\"true\" name=\"pll2.pll\">\r\n\t  \r\n\t<![CDATA[prev\nlines]]>  </lib>\n"
+        "    <lib link=\"true\" name=\"pll1.pll\">  </lib>\n"
+        "  </libraries>\n"
+        "</plcProject>\n"sv);
+    const fs::path out_path = tmp_dir.path() / "out.ppjs";
+
+    ll::update_project_stream(prj_file.path(), out_path, [](std::string&&)noexcept{});
+    const std::string streamed = test::read_file_content(out_path.string());
+    ut::expect( streamed.contains("<lib link=\"true\" name=\"pll1.pll\">\n       <![CDATA[abc]]></lib>"sv) ) << "leading spaces should be kept\n";
+
+    // Byte for byte the result of the whole file update
+    ll::update_project_libraries(prj_file.path(), {}, [](std::string&&)noexcept{});
+    ut::expect( prj_file.content()==streamed );
+   };
+
+};///////////////////////////////////////////////////////////////////////////
+#endif // TEST_UNITS ////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
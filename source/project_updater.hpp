@@ -2,7 +2,7 @@
 //  ---------------------------------------------
 //  Updates the libraries in a LogicLab project
 //  ---------------------------------------------
-//  #include "project_updater.hpp" // ll::update_project_libraries()
+//  #include "project_updater.hpp" // ll::update_project_libraries(), ll::library_sources
 //  ---------------------------------------------
 #include <cassert>
 #include <stdexcept> // std::runtime_error
@@ -11,12 +11,26 @@
 #include <string_view>
 #include <vector>
 #include <optional>
+#include <memory> // std::unique_ptr, std::shared_ptr
+#include <future> // std::promise, std::future
+#include <atomic>
+#include <thread> // std::jthread
+#include <mutex> // std::mutex, std::scoped_lock
+#include <utility> // std::pair
+#include <numeric> // std::iota
 
 #include "filesystem_utilities.hpp" // fs::*, fsu::*
 #include "memory_mapped_file.hpp" // sys::memory_mapped_file
 #include "unicode_text.hpp" // utxt::*
-#include "text_parser_xml.hpp" // text::xml::Parser
+#include "text_parser_xml.hpp" // text::xml::Parser, text::xml::find_open_tag()
 #include "file_write.hpp" // sys::file_write()
+#include "file_range_source.hpp" // sys::file_range_source
+#include "mapped_files_cache.hpp" // sys::mapped_files_cache<>
+#include "file_data_cache.hpp" // sys::file_data_cache<>
+#include "parallel_tasks.hpp" // MG::run_in_parallel()
+#include "issues_collector.hpp" // MG::issues
+#include "string_write.hpp" // MG::string_write
+#include "libraries_converter.hpp" // ll::parse_library(), ll::file_type
 
 using namespace std::literals; // "..."sv
 
@@ -27,7 +41,52 @@ namespace ll
 
 // Note: valid for both ppjs and plcprj project types
 static constexpr std::u32string_view libraries_tag_name = U"libraries"sv;
+static constexpr std::string_view libraries_tag_name_utf8 = "libraries"sv;
 static constexpr std::u32string_view library_tag_name = U"lib"sv;
+static constexpr std::string_view library_tag_name_utf8 = "lib"sv;
+static constexpr std::u32string_view project_tag_name = U"plcProject"sv;
+static constexpr std::u32string_view sources_tag_name = U"sources"sv;
+
+//---------------------------------------------------------------------------
+// The names to match with the parser event views, encoded as the project
+template<utxt::Enc ENC>
+struct encoded_names_t final
+   {
+    std::string project_tag = utxt::encode_as<ENC>(project_tag_name);
+    std::string sources_tag = utxt::encode_as<ENC>(sources_tag_name);
+    std::string libraries_tag = utxt::encode_as<ENC>(libraries_tag_name);
+    std::string library_tag = utxt::encode_as<ENC>(library_tag_name);
+    std::string link_attr = utxt::encode_as<ENC>(U"link"sv);
+    std::string link_value = utxt::encode_as<ENC>(U"true"sv);
+    std::string name_attr = utxt::encode_as<ENC>(U"name"sv);
+   };
+template<utxt::Enc ENC>
+[[nodiscard]] const encoded_names_t<ENC>& encoded_names()
+{
+    static const encoded_names_t<ENC> names;
+    return names;
+}
+
+//---------------------------------------------------------------------------
+// Position the parser on the <libraries> open tag, skipping the
+// subtrees that can't contain it (the bulk of the project code)
+template<utxt::Enc ENC>
+void seek_libraries_tag(text::xml::Parser<ENC>& parser)
+{
+    const encoded_names_t<ENC>& names = encoded_names<ENC>();
+    while( const auto& event = parser.next_event_view() )
+       {
+        if( event.is_open_tag(names.libraries_tag) )
+           {
+            return;
+           }
+        else if( event.is_open_tag() and not event.is_open_tag(names.project_tag) and not event.is_open_tag(names.sources_tag) )
+           {
+            parser.skip_current_element();
+           }
+       }
+    throw parser.create_parse_error( std::format("Invalid project (<{}> not found)"sv, utxt::to_utf8(libraries_tag_name)), 1 );
+}
 
 
 //---------------------------------------------------------------------------
@@ -46,6 +105,89 @@ enum class library_type : std::uint8_t { unknown, pll, plclib };
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// A source to convert in place of reading the linked library file
+class library_sources;
+struct library_source_t final
+   {
+    fs::path path;
+    file_type type;
+    const library_sources* sources; // Owner
+   };
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The sources (h, pll) of the linked libraries: a library with the same
+// name is obtained converting its source in memory, its file is not needed.
+// The conversions issues are collected to be forwarded later. Thread safe
+class library_sources final
+{
+ private:
+    MG::options_map m_conv_options;
+    std::vector<library_source_t> m_sources;
+    mutable std::mutex m_issues_mutex;
+    mutable std::vector<std::string> m_issues; // Not yet forwarded
+
+ public:
+    library_sources(const std::vector<fs::path>& sources_paths, MG::options_map conv_options)
+      : m_conv_options{ std::move(conv_options) }
+       {
+        m_sources.reserve( sources_paths.size() );
+        for( const auto& source_path : sources_paths )
+           {
+            const file_type typ = recognize_file_type( source_path.string() );
+            if( typ!=file_type::h and typ!=file_type::pll )
+               {
+                throw std::invalid_argument{ std::format("Not a library source: {}", source_path.string()) };
+               }
+            m_sources.push_back( library_source_t{ fs::absolute(source_path), typ, this } );
+           }
+       }
+
+    library_sources(const library_sources&) = delete; // Prevent copy
+    library_sources& operator=(const library_sources&) = delete;
+    library_sources(library_sources&&) = delete; // Prevent move
+    library_sources& operator=(library_sources&&) = delete;
+
+    [[nodiscard]] const MG::options_map& conv_options() const noexcept { return m_conv_options; }
+
+    //-----------------------------------------------------------------------
+    // A pll can be obtained just from a header
+    [[nodiscard]] const library_source_t* find_for(const fs::path& lib_path, const library_type lib_type) const noexcept
+       {
+        for( const auto& source : m_sources )
+           {
+            if( source.path.stem()==lib_path.stem() and
+                (lib_type==library_type::plclib or (lib_type==library_type::pll and source.type==file_type::h)) )
+               {
+                return &source;
+               }
+           }
+        return nullptr;
+       }
+
+    //-----------------------------------------------------------------------
+    void collect_issue(std::string&& issue) const
+       {
+        std::scoped_lock lock(m_issues_mutex);
+        m_issues.push_back( std::move(issue) );
+       }
+
+    //-----------------------------------------------------------------------
+    void forward_issues(fnotify_t const& notify_issue) const
+       {
+        std::vector<std::string> issues;
+           {std::scoped_lock lock(m_issues_mutex);
+            std::swap(issues, m_issues);
+           }
+        for( auto& issue : issues )
+           {
+            notify_issue( std::move(issue) );
+           }
+       }
+};
+
+
 //---------------------------------------------------------------------------
 struct lib_t final
    {
@@ -53,6 +195,7 @@ struct lib_t final
     std::size_t chunk_start = 0u;
     std::size_t chunk_end = 0u;
     library_type type = library_type::unknown;
+    const library_source_t* source = nullptr; // If converted on the fly
 
     lib_t(fs::path&& pth, const library_type typ) noexcept
       : path{ std::move(pth) }
@@ -65,146 +208,149 @@ using libs_t = std::vector<lib_t>;
 
 
 //---------------------------------------------------------------------------
+// The library of the current <lib> event, if linked and existing
+// (or having a source)
 template<utxt::Enc ENC>
-[[nodiscard]] libs_t collect_linked_libs(const std::string_view bytes, std::string&& file_path, fnotify_t const& notify_issue)
+[[nodiscard]] std::optional<lib_t> check_linked_lib(const text::xml::Parser<ENC>& parser, const fs::path& base_dir, const library_sources* const sources) noexcept
 {
-    libs_t libs;
+    const encoded_names_t<ENC>& names = encoded_names<ENC>();
+    const auto& event = parser.curr_event_view();
+    assert( event.is_open_tag(names.library_tag) );
 
-    text::xml::Parser<ENC> parser{bytes};
-    parser.set_on_notify_issue(notify_issue);
-    parser.set_file_path( std::move(file_path) );
+    std::optional<lib_t> lib_data;
 
-    // Both project types (ppjs, plcprj) are a xml file that contains the following structure:
-    // plcProject/sources/libraries/lib[link,name]
-
-    class prj_parser_t
-    {
-     private:
-        text::xml::Parser<ENC>& parser;
-
-     public:
-        explicit prj_parser_t(text::xml::Parser<ENC>& prs) noexcept
-          : parser(prs)
-           {
-            parser.options().set_collect_comment_text(false);
-            parser.options().set_collect_text_sections(false);
-           }
+    // I'll collect only libraries with attribute link="true"
+    if( not event.has_attribute_with_value(names.link_attr, names.link_value) )
+       {
+        parser.notify_issue("Skipping library (need link=\"true\")"sv);
+        return lib_data;
+       }
 
-        void seek_open_tag(const std::u32string_view tag_name)
-           {
-            while( parser.next_event() )
-               {
-                if( parser.curr_event().is_open_tag(tag_name) )
-                   {
-                    return;
-                   }
-               }
-            throw parser.create_parse_error( std::format("Invalid project (<{}> not found)"sv, utxt::to_utf8(tag_name)), 1 );
-           }
+    const auto name = event.find_attribute(names.name_attr);
+    if( not name or not name->value.has_value() )
+       {
+        parser.notify_issue("Skipping unnamed library (expected name=\"...\")"sv);
+        return lib_data;
+       }
 
-        void seek_close_tag(const std::u32string_view tag_name)
-           {
-            const auto start_line = parser.curr_line();
-            do {
-                if( parser.curr_event().is_close_tag(tag_name) )
-                   {
-                    return;
-                   }
-                else if( parser.curr_event().is_open_tag(tag_name) )
-                   {
-                    throw parser.create_parse_error( std::format("Unexpected nested <{}>"sv, utxt::to_utf8(tag_name)) );
-                   }
-               }
-            while( parser.next_event() );
+    const std::u32string name_value = utxt::to_utf32<ENC>(name->value.value());
+    if( name_value.empty() )
+       {
+        parser.notify_issue("Skipping library with empty name (name=\"\")"sv);
+        return lib_data;
+       }
 
-            throw parser.create_parse_error( std::format("Unclosed <{}>"sv, utxt::to_utf8(tag_name)), start_line );
-           }
+    fs::path lib_path = base_dir / fs::path{name_value}; // Not touched if absolute; not normalized, the system resolves '..' after the symlinks
+    const library_type lib_type = recognize_library_type(name_value);
+    const library_source_t* const lib_source = sources ? sources->find_for(lib_path, lib_type) : nullptr;
+    if( std::error_code ec; not lib_source and not fs::exists(lib_path, ec) )
+       {
+        parser.notify_issue( std::format("Skipping broken linked library (name=\"{}\" path=\"{}\")"sv, utxt::to_utf8(name_value), lib_path.string()) );
+        return lib_data;
+       }
 
-        std::optional<lib_t> check_and_collect_lib_data() noexcept
-           {
-            assert( parser.curr_event().is_open_tag(library_tag_name) );
+    if( lib_type==library_type::unknown )
+       {
+        parser.notify_issue( std::format("Unrecognized library (name=\"{}\")"sv, utxt::to_utf8(name_value)) );
+       }
 
-            std::optional<lib_t> lib_data;
+    lib_data.emplace( std::move(lib_path), lib_type );
+    lib_data->source = lib_source;
+    return lib_data;
+}
 
-            // I'll collect only libraries with attribute link="true"
-            if( not parser.curr_event().has_attribute_with_value(U"link"sv, U"true"sv) )
-               {
-                parser.notify_issue("Skipping library (need link=\"true\")"sv);
-                return lib_data;
-               }
 
-            const auto name = parser.curr_event().attributes().value_of(U"name"sv);
-            if( not name.has_value() or not name->get().has_value() )
-               {
-                parser.notify_issue("Skipping unnamed library (expected name=\"...\")"sv);
-                return lib_data;
-               }
+//---------------------------------------------------------------------------
+// The position of a <lib> element in a project, to reach it again
+// without parsing the whole file
+struct lib_element_t final
+   {
+    std::size_t tag_offset = 0u; // Of '<'
+    std::size_t line = 1u; // Of '<'
+    std::size_t content_start = 0u;
+    std::size_t content_end = 0u;
+    bool is_empty = false; // <lib/>
+   };
+using lib_elements_t = std::vector<lib_element_t>;
 
-            const std::u32string_view name_value{ name->get().value() };
-            if( name_value.empty() )
-               {
-                parser.notify_issue("Skipping library with empty name (name=\"\")"sv);
-                return lib_data;
-               }
+//---------------------------------------------------------------------------
+// Reused while the project file doesn't change, keyed by its canonical path
+using projects_index_cache = sys::file_data_cache<lib_elements_t>;
 
-            std::error_code ec;
-            fs::path lib_path = fs::absolute(fs::path{name_value}, ec); // Uses fs::current_path()
-            if( ec )
-               {
-                parser.notify_issue( std::format("Skipping broken linked library (name=\"{}\"): {}"sv, utxt::to_utf8(name_value), ec.message()) );
-                return lib_data;
-               }
-            if( not fs::exists(lib_path) )
-               {
-                parser.notify_issue( std::format("Skipping broken linked library (name=\"{}\" path=\"{}\")"sv, utxt::to_utf8(name_value), lib_path.string()) );
-                return lib_data;
-               }
+//---------------------------------------------------------------------------
+template<utxt::Enc ENC>
+[[nodiscard]] lib_elements_t index_lib_elements(const std::string_view bytes, std::string&& file_path)
+{
+    lib_elements_t elements;
 
-            const library_type lib_type = recognize_library_type(name_value);
-            if( lib_type==library_type::unknown )
-               {
-                parser.notify_issue( std::format("Unrecognized library (name=\"{}\")"sv, utxt::to_utf8(name_value)) );
-               }
+    text::xml::Parser<ENC> parser{bytes};
+    parser.set_file_path( std::move(file_path) );
+    parser.options().set_collect_comment_text(false);
+    parser.options().set_collect_text_sections(false);
 
-            lib_data.emplace( std::move(lib_path), lib_type );
-            return lib_data;
+    // Both project types (ppjs, plcprj) are a xml file that contains the following structure:
+    // plcProject/sources/libraries/lib[link,name]
+    // Expecting a <libraries> tag, typically after a lot of code
+    if constexpr( ENC==utxt::Enc::UTF8 )
+       {// Can skip the bulk without decoding it
+        if( const auto libraries_pos = text::xml::find_open_tag(bytes, libraries_tag_name_utf8); libraries_pos.has_value() )
+           {
+            parser.jump_to(libraries_pos->byte_offset, libraries_pos->line);
            }
+       }
+    seek_libraries_tag(parser);
 
-        void collect_lib_and_put_in(libs_t& libs)
+    // Locate the contained <libs>, the events are not decoded
+    const encoded_names_t<ENC>& names = encoded_names<ENC>();
+    while( const auto& event = parser.next_event_view() )
+       {
+        if( event.is_open_tag(names.library_tag) )
            {
-            std::optional<lib_t> lib_data = check_and_collect_lib_data();
-            if( not lib_data.has_value() )
-               {// Skipping this lib
-                parser.next_event(); // Skip opening tag
-                seek_close_tag(library_tag_name);
-                return;
-               }
-
-            // Now I'll retrieve start and end of the library data chunk
-            parser.next_event(); // Skip opening tag
-            lib_data.value().chunk_start = parser.curr_event().start_byte_offset();
-            seek_close_tag(library_tag_name);
-            lib_data.value().chunk_end = parser.curr_event().start_byte_offset();
-
-            libs.push_back( std::move(lib_data.value()) );
+            lib_element_t& element = elements.emplace_back();
+            element.tag_offset = event.start_byte_offset();
+            element.line = event.start_line();
+            element.is_empty = parser.is_empty_element();
+            parser.skip_any_space();
+            element.content_start = parser.curr_codepoint_byte_offset();
+            parser.skip_current_element(true);
+            element.content_end = element.is_empty ? element.content_start : parser.curr_event_view().start_byte_offset();
            }
+        else if( event.is_close_tag(names.libraries_tag) )
+           {
+            break;
+           }
+       }
 
-    } prj_parser(parser);
+    return elements;
+}
+//---------------------------------------------------------------------------
+[[nodiscard]] lib_elements_t index_lib_elements(const std::string_view bytes, const utxt::Enc bytes_enc, std::string&& file_path)
+{
+    TEXT_DISPATCH_TO_ENC(bytes_enc, index_lib_elements<, >(bytes, std::move(file_path)))
+}
 
 
-    // Expecting a <libraries> tag
-    prj_parser.seek_open_tag(libraries_tag_name);
+//---------------------------------------------------------------------------
+// Checks the indexed <lib> elements, parsing just their open tags
+template<utxt::Enc ENC>
+[[nodiscard]] libs_t collect_linked_libs(const std::string_view bytes, const lib_elements_t& elements, const fs::path& base_dir, const library_sources* const sources, std::string&& file_path, fnotify_t const& notify_issue)
+{
+    libs_t libs;
 
-    // Collect contained <libs>
-    while( parser.next_event() )
+    text::xml::Parser<ENC> parser{bytes};
+    parser.set_on_notify_issue(notify_issue);
+    parser.set_file_path( std::move(file_path) );
+
+    for( const lib_element_t& element : elements )
        {
-        if( parser.curr_event().is_open_tag(library_tag_name) )
+        parser.jump_to(element.tag_offset, element.line);
+        parser.next_event_view();
+        std::optional<lib_t> lib_data = check_linked_lib(parser, base_dir, sources);
+        if( lib_data.has_value() and not element.is_empty )
            {
-            prj_parser.collect_lib_and_put_in( libs );
-           }
-        else if( parser.curr_event().is_close_tag(libraries_tag_name) )
-           {
-            break;
+            lib_data.value().chunk_start = element.content_start;
+            lib_data.value().chunk_end = element.content_end;
+            libs.push_back( std::move(lib_data.value()) );
            }
        }
 
@@ -216,19 +362,32 @@ template<utxt::Enc ENC>
     return libs;
 }
 //---------------------------------------------------------------------------
-[[nodiscard]] libs_t collect_linked_libs(const std::string_view bytes, const utxt::Enc bytes_enc, std::string&& file_path, fnotify_t const& notify_issue)
+[[nodiscard]] libs_t collect_linked_libs(const std::string_view bytes, const utxt::Enc bytes_enc, const lib_elements_t& elements, const fs::path& base_dir, const library_sources* const sources, std::string&& file_path, fnotify_t const& notify_issue)
 {
-    TEXT_DISPATCH_TO_ENC(bytes_enc, collect_linked_libs<, >(bytes, std::move(file_path), notify_issue))
+    TEXT_DISPATCH_TO_ENC(bytes_enc, collect_linked_libs<, >(bytes, elements, base_dir, sources, std::move(file_path), notify_issue))
 }
 
 //---------------------------------------------------------------------------
-// Parse original project detecting contained libs
-[[nodiscard]] libs_t parse_project_file( const fs::path& project_file_path, const std::string_view project_file_bytes, const utxt::Enc project_bytes_enc, fnotify_t const& notify_issue )
+// Parse original project detecting contained libs; with 'index_cache'
+// an unchanged project is not parsed again
+[[nodiscard]] libs_t parse_project_file( const fs::path& project_file_path, const std::string_view project_file_bytes, const utxt::Enc project_bytes_enc, fnotify_t const& notify_issue, const library_sources* const sources =nullptr, projects_index_cache* const index_cache =nullptr )
 {
-    // Temporarily switch current path to properly resolve libraries paths relative to project file
-    fsu::CurrentPathLocalChanger curr_path_changed( project_file_path.parent_path() );
+    // Libraries paths are relative to the project file; not changing the
+    // current path (of the whole process), so projects can be parsed concurrently
+    const fs::path project_dir = fs::absolute(project_file_path).parent_path();
 
-    return collect_linked_libs(project_file_bytes, project_bytes_enc, project_file_path.string(), notify_issue);
+    const auto index = [&project_file_path, project_bytes_enc](const std::string_view bytes)
+       {
+        return index_lib_elements(bytes, project_bytes_enc, project_file_path.string());
+       };
+    if( index_cache )
+       {
+        std::error_code ec;
+        const fs::path canonical_path = fs::weakly_canonical(project_file_path, ec);
+        const std::shared_ptr<const lib_elements_t> elements = index_cache->get(project_file_path, ec ? project_file_path.string() : canonical_path.string(), project_file_bytes, index);
+        return collect_linked_libs(project_file_bytes, project_bytes_enc, *elements, project_dir, sources, project_file_path.string(), notify_issue);
+       }
+    return collect_linked_libs(project_file_bytes, project_bytes_enc, index(project_file_bytes), project_dir, sources, project_file_path.string(), notify_issue);
 }
 
 
@@ -239,34 +398,26 @@ template<utxt::Enc ENC>
     text::xml::Parser<ENC> parser{plclib_bytes};
     parser.set_file_path( std::move(file_path) );
 
+    const std::string_view lib_tag = encoded_names<ENC>().library_tag;
+    const auto& event = parser.curr_event_view();
+
     // Seeking <lib>
-    while( parser.next_event() and not parser.curr_event().is_open_tag(library_tag_name) );
-    if( not parser.curr_event() )
+    while( parser.next_event_view() and not event.is_open_tag(lib_tag) );
+    if( not event )
        {
         throw parser.create_parse_error( std::format("Invalid plclib (<{}> not found)"sv, utxt::to_utf8(library_tag_name)), 1 );
        }
-    const auto start_line = parser.curr_line();
-    parser.next_event();
-    const auto chunk_start = parser.curr_event().start_byte_offset();
-
-    // Seeking </lib>
-    do {
-        if( parser.curr_event().is_close_tag(library_tag_name) )
-           {
-            break;
-           }
-        else if( parser.curr_event().is_open_tag(library_tag_name) )
-           {
-            throw parser.create_parse_error( std::format("Invalid plclib (unexpected nested <{}>)"sv, utxt::to_utf8(library_tag_name)) );
-           }
-       }
-    while( parser.next_event() );
-    if( not parser.curr_event() )
+    if( parser.is_empty_element() )
        {
-        throw parser.create_parse_error( std::format("Invalid plclib (unclosed <{}>)"sv, utxt::to_utf8(library_tag_name)), start_line );
+        return {};
        }
 
-    return plclib_bytes.substr(chunk_start, parser.curr_event().start_byte_offset()-chunk_start);
+    // Skipping its content until </lib>
+    parser.skip_any_space();
+    const auto chunk_start = parser.curr_codepoint_byte_offset();
+    parser.skip_current_element(true);
+
+    return plclib_bytes.substr(chunk_start, parser.curr_event_view().start_byte_offset()-chunk_start);
 }
 //---------------------------------------------------------------------------
 [[nodiscard]] std::string_view get_plclib_content(const std::string_view plclib_bytes, std::string&& file_path)
@@ -278,58 +429,330 @@ template<utxt::Enc ENC>
 
 
 //---------------------------------------------------------------------------
-template<utxt::Enc out_enc>
-void insert_library(const lib_t& lib, sys::file_write& out_file)
+// The content of <lib> as written by plclib::write_lib(), located as
+// get_plclib_content() would do, without parsing
+[[nodiscard]] std::string_view get_written_plclib_content(const std::string_view plclib_text)
 {
-    const sys::memory_mapped_file lib_file_mapped{ lib.path.string().c_str() };
+    const std::size_t i_lib = plclib_text.find("<lib "sv);
+    const std::size_t i_lib_end = i_lib==std::string_view::npos ? i_lib : plclib_text.find('>', i_lib);
+    const std::size_t i_start = i_lib_end==std::string_view::npos ? i_lib_end : plclib_text.find_first_not_of(" \t\r\n"sv, i_lib_end+1u);
+    const std::size_t i_end = plclib_text.rfind("</lib>"sv);
+    if( i_start==std::string_view::npos or i_end==std::string_view::npos or i_start>i_end )
+       {
+        throw std::runtime_error{"Unexpected plclib writer output"};
+       }
+    return plclib_text.substr(i_start, i_end-i_start);
+}
+
+//---------------------------------------------------------------------------
+// The library file content that would be obtained converting its source
+[[nodiscard]] std::string convert_library_source(const library_source_t& source, const library_type lib_type, const std::string_view source_bytes)
+{
+    const MG::options_map& conv_options = source.sources->conv_options();
+    plcb::Library lib( source.path.stem().string() );
+    parse_library(lib, source.path.string(), source.type, source_bytes, conv_options, [&source](std::string&& issue){ source.sources->collect_issue(std::move(issue)); });
+    lib.throw_if_incoherent();
+
+    MG::string_write out;
+    if( lib_type==library_type::plclib )
+       {
+        plclib::write_lib(out, lib, conv_options);
+       }
+    else
+       {
+        pll::write_lib(out, lib, conv_options);
+       }
+    return out.release();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// A library content encoded as a project. The content refers to the
+// mapped library or to the re-encoded buffer, so this must not move
+struct encoded_library_t final
+   {
     std::string reencoded_buf;
+    std::string head;
+    std::string_view content;
+    std::string tail;
+
+    encoded_library_t() noexcept = default;
+    encoded_library_t(const encoded_library_t&) = delete; // Prevent copy
+    encoded_library_t& operator=(const encoded_library_t&) = delete;
+    encoded_library_t(encoded_library_t&&) = delete; // Prevent move
+    encoded_library_t& operator=(encoded_library_t&&) = delete;
+   };
 
-    if( lib.type==library_type::plclib )
+//---------------------------------------------------------------------------
+template<utxt::Enc out_enc>
+void encode_library_content(const library_type lib_type, const std::string_view lib_content, encoded_library_t& encoded)
+{
+    if( lib_type==library_type::plclib )
        {// Insert the content of <lib> tag
-        const std::string_view content_to_insert = get_plclib_content( lib_file_mapped.as_string_view(), lib.path.string() );
-        out_file << utxt::encode_if_necessary_as<out_enc>(content_to_insert, reencoded_buf);
+        encoded.content = utxt::encode_if_necessary_as<out_enc>(lib_content, encoded.reencoded_buf);
        }
     else
        {// Insert the file content (excluding BOM) in a CDATA section
-        out_file << utxt::encode_as<out_enc>(U"<![CDATA["sv);
+        encoded.head = utxt::encode_as<out_enc>(U"<![CDATA["sv);
+        encoded.content = utxt::encode_if_necessary_as<out_enc>(lib_content, encoded.reencoded_buf, utxt::flag::SKIP_BOM);
+        encoded.tail = utxt::encode_as<out_enc>(U"]]>"sv);
+       }
+}
+//---------------------------------------------------------------------------
+[[nodiscard]] std::shared_ptr<const encoded_library_t> encode_library_content(const library_type lib_type, const std::string_view lib_content, const utxt::Enc out_enc)
+{
+    auto encoded = std::make_shared<encoded_library_t>();
+    const auto encode = [&]() { TEXT_DISPATCH_TO_ENC(out_enc, encode_library_content<, >(lib_type, lib_content, *encoded)) };
+    encode();
+    return encoded;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// The part of a library file to be inserted in the projects, along with
+// its encodings as the projects that included it. Thread safe
+class library_content_t final
+{
+ private:
+    library_type m_type;
+    std::string m_converted; // The library converted from its source
+    std::string_view m_content; // In the mapped library or in the converted one
+    mutable std::mutex m_encoded_mutex;
+    mutable std::vector<std::pair<utxt::Enc, std::shared_ptr<const encoded_library_t>>> m_encoded;
+
+ public:
+    library_content_t(const library_type typ, const std::string_view content) noexcept
+      : m_type{typ}
+      , m_content{content}
+       {}
+
+    library_content_t(const library_type typ, std::string&& converted)
+      : m_type{typ}
+      , m_converted{ std::move(converted) }
+      , m_content{ typ==library_type::plclib ? get_written_plclib_content(m_converted) : std::string_view{m_converted} }
+       {}
+
+    [[nodiscard]] std::string_view content() const noexcept { return m_content; }
+
+    [[nodiscard]] std::shared_ptr<const encoded_library_t> encoded_as(const utxt::Enc enc) const
+       {
+        std::scoped_lock lock(m_encoded_mutex);
+        for( const auto& [encoded_enc, encoded] : m_encoded )
+           {
+            if( encoded_enc==enc ) return encoded;
+           }
+        return m_encoded.emplace_back(enc, encode_library_content(m_type, m_content, enc)).second;
+       }
+};
+
+//---------------------------------------------------------------------------
+// To keep in memory when updating many projects, or many times projects
+// with unchanged libraries. Keyed by the canonical library path (or of
+// the source, along with the conversion options)
+using libraries_content_cache = sys::mapped_files_cache<library_content_t>;
+
+//---------------------------------------------------------------------------
+[[nodiscard]] std::string_view get_library_content(const lib_t& lib, const std::string_view lib_bytes)
+{
+    return lib.type==library_type::plclib ? get_plclib_content(lib_bytes, lib.path.string()) : lib_bytes;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// What to write in place of a library in the project, prepared in advance
+struct prepared_library_t final
+   {
+    std::unique_ptr<const sys::memory_mapped_file> mapped; // When not cached
+    std::string converted; // When not cached and having a source
+    std::shared_ptr<const libraries_content_cache::entry_t> cached;
+    std::shared_ptr<const encoded_library_t> encoded; // Encoded as the project
+    std::optional<std::uint64_t> content_offset; // In the library file, if not re-encoded
+    sys::file_stamp_t stamp; // Of the mapped library file
+
+    [[nodiscard]] bool is_same_of(std::string_view chunk) const noexcept
+       {
+        if( chunk.size()!=encoded->head.size()+encoded->content.size()+encoded->tail.size() or not chunk.starts_with(encoded->head) )
+           {
+            return false;
+           }
+        chunk.remove_prefix(encoded->head.size());
+        return chunk.starts_with(encoded->content) and chunk.ends_with(encoded->tail);
+       }
+   };
 
-        out_file << utxt::encode_if_necessary_as<out_enc>(lib_file_mapped.as_string_view(), reencoded_buf, utxt::flag::SKIP_BOM);
+//---------------------------------------------------------------------------
+[[nodiscard]] std::unique_ptr<prepared_library_t> prepare_library(const lib_t& lib, const utxt::Enc original_bytes_enc, libraries_content_cache* const cache)
+{
+    auto prepared = std::make_unique<prepared_library_t>();
+    const fs::path& file_path = lib.source ? lib.source->path : lib.path;
+    std::string_view lib_bytes;
+    if( cache )
+       {
+        std::error_code ec;
+        const fs::path canonical_path = fs::weakly_canonical(file_path, ec);
+        std::string key = ec ? file_path.string() : canonical_path.string();
+        if( lib.source )
+           {
+            key = std::format("{}|{}|{}", key, lib.type==library_type::plclib ? "plclib"sv : "pll"sv, lib.source->sources->conv_options().to_string());
+           }
+        prepared->cached = cache->get(file_path, std::move(key), [&lib](const std::string_view bytes)
+           {
+            if( lib.source )
+               {
+                return library_content_t{ lib.type, convert_library_source(*lib.source, lib.type, bytes) };
+               }
+            return library_content_t{ lib.type, get_library_content(lib, bytes) };
+           });
+        prepared->encoded = prepared->cached->data().encoded_as(original_bytes_enc);
+        prepared->stamp = prepared->cached->stamp();
+        lib_bytes = prepared->cached->bytes();
+       }
+    else
+       {
+        prepared->stamp = sys::file_stamp_t::of(file_path); // Before mapping
+        prepared->mapped = std::make_unique<const sys::memory_mapped_file>( file_path.string().c_str() );
+        lib_bytes = prepared->mapped->as_string_view();
+        if( lib.source )
+           {
+            prepared->converted = convert_library_source(*lib.source, lib.type, lib_bytes);
+            const std::string_view content = lib.type==library_type::plclib ? get_written_plclib_content(prepared->converted) : std::string_view{prepared->converted};
+            prepared->encoded = encode_library_content(lib.type, content, original_bytes_enc);
+           }
+        else
+           {
+            prepared->encoded = encode_library_content(lib.type, get_library_content(lib, lib_bytes), original_bytes_enc);
+           }
+       }
 
-        out_file << utxt::encode_as<out_enc>(U"]]>"sv);
+    const std::string_view content = prepared->encoded->content;
+    if( content.data()>=lib_bytes.data() and content.data()<lib_bytes.data()+lib_bytes.size() )
+       {
+        prepared->content_offset = static_cast<std::uint64_t>(content.data() - lib_bytes.data());
        }
+    return prepared;
 }
 //---------------------------------------------------------------------------
-void insert_library(const lib_t& lib, sys::file_write& out_file, const utxt::Enc original_bytes_enc)
+// The content as is in the library file is copied kernel side, if possible
+// (the file is still the mapped one)
+void insert_library(const lib_t& lib, const prepared_library_t& prepared, sys::file_write& out_file)
 {
-    TEXT_DISPATCH_TO_ENC(original_bytes_enc, insert_library<, >(lib, out_file))
+    const encoded_library_t& encoded = *prepared.encoded;
+    out_file << encoded.head;
+    if( prepared.content_offset.has_value() and encoded.content.size()>=sys::file_range_source::min_size )
+       {
+        const sys::file_range_source lib_file{ lib.path.string().c_str(), prepared.stamp };
+        lib_file.append_to(out_file, prepared.content_offset.value(), encoded.content);
+       }
+    else
+       {
+        out_file << encoded.content;
+       }
+    out_file << encoded.tail;
 }
 
 
 //---------------------------------------------------------------------------
-void write_project_file(const fs::path& output_file_path, const std::string_view original_bytes, const utxt::Enc original_bytes_enc, const libs_t& libs)
+// With more threads the libraries are prepared (mapped, extracted and
+// re-encoded) by a pool ahead of the writer, that follows the project order.
+// The unchanged parts of the original file are copied kernel side, if possible
+void write_project_file(const fs::path& output_file_path, const fs::path& original_file_path, const sys::file_stamp_t& original_file_stamp, const std::string_view original_bytes, const utxt::Enc original_bytes_enc, const libs_t& libs, libraries_content_cache* const cache =nullptr, const unsigned int threads_count =1u)
 {
+    const sys::file_range_source original_file{ original_file_path.string().c_str(), original_file_stamp };
     sys::file_write out_file{ output_file_path.string().c_str() };
     out_file.set_buffer_size(4_MB);
     std::size_t i_chunk_byte_offset = 0;
 
-    for( const auto& lib: libs)
+    const auto write_chunk_before = [&](const lib_t& lib)
        {
         //dbg_print("lib {} at chunk {}-{}\n", lib.path.string(), lib.chunk_start, lib.chunk_end);
 
         // Note: No need to re-encode when copying the original content
-        out_file << original_bytes.substr(i_chunk_byte_offset, lib.chunk_start-i_chunk_byte_offset);
+        original_file.append_to(out_file, i_chunk_byte_offset, original_bytes.substr(i_chunk_byte_offset, lib.chunk_start-i_chunk_byte_offset));
         i_chunk_byte_offset = lib.chunk_end;
+       };
 
-        insert_library(lib, out_file, original_bytes_enc);
+    if( threads_count<=1u or libs.size()<=1u )
+       {
+        for( const auto& lib: libs)
+           {
+            write_chunk_before(lib);
+            insert_library(lib, *prepare_library(lib, original_bytes_enc, cache), out_file);
+           }
+       }
+    else
+       {
+        using prepared_ptr = std::unique_ptr<prepared_library_t>;
+        std::vector<std::promise<prepared_ptr>> promises(libs.size());
+        std::vector<std::future<prepared_ptr>> futures;
+        futures.reserve( libs.size() );
+        for( auto& promise : promises ) futures.push_back( promise.get_future() );
+        std::atomic<bool> aborted{false};
+
+        std::jthread preparer([&]() noexcept
+           {
+            MG::run_in_parallel(libs.size(), threads_count, [&](const std::size_t idx) noexcept
+               {
+                if( aborted.load(std::memory_order_relaxed) )
+                   {// Nobody will wait it
+                    promises[idx].set_value(nullptr);
+                    return;
+                   }
+                try{
+                    promises[idx].set_value( prepare_library(libs[idx], original_bytes_enc, cache) );
+                   }
+                catch(...)
+                   {
+                    promises[idx].set_exception( std::current_exception() );
+                   }
+               });
+           });
+
+        try{
+            for( std::size_t idx=0; idx<libs.size(); ++idx )
+               {
+                write_chunk_before(libs[idx]);
+                insert_library(libs[idx], *futures[idx].get(), out_file); // Released once written
+               }
+           }
+        catch(...)
+           {
+            aborted.store(true, std::memory_order_relaxed);
+            throw;
+           }
        }
 
-    out_file << original_bytes.substr(i_chunk_byte_offset);
+    original_file.append_to(out_file, i_chunk_byte_offset, original_bytes.substr(i_chunk_byte_offset));
 }
 
 
 //---------------------------------------------------------------------------
-void parse_and_rewrite_project( const fs::path& project_file_path, const fs::path& output_file_path, fnotify_t const& notify_issue )
+// Whether the project already contains the current content of all its
+// libraries. Stops at the first difference
+[[nodiscard]] bool are_libraries_current(const std::string_view original_bytes, const utxt::Enc original_bytes_enc, const libs_t& libs, libraries_content_cache* const cache, const unsigned int threads_count)
 {
+    std::atomic<bool> current{true};
+    MG::run_in_parallel(libs.size(), threads_count, [&](const std::size_t idx)
+       {
+        if( not current.load(std::memory_order_relaxed) )
+           {
+            return;
+           }
+        const lib_t& lib = libs[idx];
+        if( not prepare_library(lib, original_bytes_enc, cache)->is_same_of(original_bytes.substr(lib.chunk_start, lib.chunk_end-lib.chunk_start)) )
+           {
+            current.store(false, std::memory_order_relaxed);
+           }
+       });
+    return current.load();
+}
+
+
+//---------------------------------------------------------------------------
+// Returns false if nothing was written because 'only_if_changed'
+// and the project already contains the current libraries
+bool parse_and_rewrite_project( const fs::path& project_file_path, const fs::path& output_file_path, fnotify_t const& notify_issue, libraries_content_cache* const cache =nullptr, const unsigned int threads_count =1u, const bool only_if_changed =false, const library_sources* const sources =nullptr, projects_index_cache* const index_cache =nullptr )
+{
+    const sys::file_stamp_t project_file_stamp = sys::file_stamp_t::of(project_file_path); // Before mapping
     const sys::memory_mapped_file project_file_mapped{ project_file_path.string().c_str() };
     const std::string_view project_file_bytes{ project_file_mapped.as_string_view() };
     if( project_file_bytes.empty() )
@@ -339,10 +762,24 @@ void parse_and_rewrite_project( const fs::path& project_file_path, const fs::pat
 
     const auto [project_bytes_enc, bom_size] = utxt::detect_encoding_of(project_file_bytes);
 
-    const libs_t libs = parse_project_file(project_file_path, project_file_bytes, project_bytes_enc, notify_issue);
+    const libs_t libs = parse_project_file(project_file_path, project_file_bytes, project_bytes_enc, notify_issue, sources, index_cache);
+
+    // What is prepared for the check is reused when writing
+    libraries_content_cache run_cache;
+    libraries_content_cache* const libs_cache = cache ? cache : (only_if_changed ? &run_cache : nullptr);
+    const auto forward_conversions_issues = [sources, &notify_issue]()
+       {
+        if( sources ) sources->forward_issues(notify_issue);
+       };
+
+    if( only_if_changed and are_libraries_current(project_file_bytes, project_bytes_enc, libs, libs_cache, threads_count) )
+       {
+        forward_conversions_issues();
+        return false;
+       }
 
     try{
-        write_project_file(output_file_path, project_file_bytes, project_bytes_enc, libs);
+        write_project_file(output_file_path, project_file_path, project_file_stamp, project_file_bytes, project_bytes_enc, libs, libs_cache, threads_count);
        }
     catch(...)
        {// Housekeeping, don't leave a half-baked project around
@@ -350,18 +787,25 @@ void parse_and_rewrite_project( const fs::path& project_file_path, const fs::pat
            {
             fs::remove(output_file_path);
            }
+        forward_conversions_issues();
         throw;
        }
+    forward_conversions_issues();
+    return true;
 }
 
 
 //---------------------------------------------------------------------------
-void update_project_libraries( const fs::path& project_file_path, fs::path output_file_path, fnotify_t const& notify_issue )
+// An original project already up to date is left untouched.
+// Returns false in that case. With 'sources', the libraries having
+// one are converted on the fly instead of reading their files
+bool update_project_libraries( const fs::path& project_file_path, fs::path output_file_path, fnotify_t const& notify_issue, libraries_content_cache* const cache =nullptr, const unsigned int threads_count =1u, const library_sources* const sources =nullptr, projects_index_cache* const index_cache =nullptr )
 {
     const bool overwrite_original = output_file_path.empty();
+    const fs::path replaced_file_path = overwrite_original ? fsu::resolve_symlink(project_file_path) : fs::path{}; // A symlink stays such
     if( overwrite_original )
        {
-        output_file_path = fsu::get_a_temporary_path_for(project_file_path);
+        output_file_path = fsu::get_a_sibling_temporary_path_for(replaced_file_path); // To be renamed in place
        }
 
     // Ensure that the output file is not the original project!
@@ -370,14 +814,73 @@ void update_project_libraries( const fs::path& project_file_path, fs::path outpu
         throw std::runtime_error{ std::format("Specified output \"{}\" collides with original file", output_file_path.string()) };
        }
 
-    parse_and_rewrite_project(project_file_path, output_file_path, notify_issue);
+    if( not parse_and_rewrite_project(project_file_path, output_file_path, notify_issue, cache, threads_count, overwrite_original, sources, index_cache) )
+       {
+        return false;
+       }
 
     if( overwrite_original )
        {
         //fsu::backup_file(project_file_path);
-        fs::copy_file(output_file_path, project_file_path, fs::copy_options::overwrite_existing);
-        fs::remove(output_file_path);
+        fsu::replace_file(output_file_path, replaced_file_path);
+       }
+    return true;
+}
+
+
+//---------------------------------------------------------------------------
+// Update in place many projects in parallel, sharing the linked libraries:
+// each one is mapped, extracted and encoded once for all the projects.
+// The issues are forwarded in projects order, the first failing project
+// (in the given order) stops the others and rethrows.
+// Returns the number of projects actually written
+std::size_t update_projects_libraries( const std::vector<fs::path>& projects_paths, const unsigned int threads_count, fnotify_t const& notify_issue, libraries_content_cache* const cache =nullptr, const library_sources* const sources =nullptr, projects_index_cache* const index_cache =nullptr )
+{
+    libraries_content_cache run_cache;
+    libraries_content_cache* const shared_cache = cache ? cache : &run_cache;
+
+    std::vector<MG::issues> projects_issues(projects_paths.size());
+    std::atomic<std::size_t> written_count{0u};
+    const auto forward_issues = [&projects_issues, &notify_issue]()
+       {
+        for( const auto& project_issues : projects_issues )
+           {
+            for( const auto& issue : project_issues )
+               {
+                notify_issue( std::string(issue) );
+               }
+           }
+       };
+
+    std::vector<std::size_t> order(projects_paths.size());
+    std::iota(order.begin(), order.end(), 0u);
+    try{
+        MG::run_in_parallel(order, threads_count, [&](const std::size_t idx)
+           {
+            MG::issues& issues = projects_issues[idx];
+            try{
+                if( update_project_libraries(projects_paths[idx], {}, std::ref(issues), shared_cache, 1u, sources, index_cache) )
+                   {
+                    ++written_count;
+                   }
+               }
+            catch( parse::error& )
+               {// Already locates the error
+                throw;
+               }
+            catch( std::exception& e )
+               {
+                throw std::runtime_error{ std::format("{}: {}", projects_paths[idx].string(), e.what()) };
+               }
+           });
        }
+    catch(...)
+       {
+        forward_issues();
+        throw;
+       }
+    forward_issues();
+    return written_count.load();
 }
 
 
@@ -389,8 +892,6 @@ void update_project_libraries( const fs::path& project_file_path, fs::path outpu
 /////////////////////////////////////////////////////////////////////////////
 #ifdef TEST_UNITS ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
-#include "issues_collector.hpp" // MG::issues
-/////////////////////////////////////////////////////////////////////////////
 static ut::suite<"project_updater"> project_updater_tests = []
 {////////////////////////////////////////////////////////////////////////////
 
@@ -485,9 +986,300 @@ ut::test("ll::update_project_libraries()") = []
         ll::update_project_libraries(prj_file.path(), {}, std::ref(issues));
         ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
         ut::expect( ut::that % prj_file.content() == expected );
+
+        // Already up to date
+        const auto time_before = fs::last_write_time(prj_file.path());
+        ut::expect( not ll::update_project_libraries(prj_file.path(), {}, std::ref(issues)) );
+        ut::expect( fs::last_write_time(prj_file.path())==time_before );
+        fs::permissions(prj_file.path(), fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+        tmp_dir.create_file("pll2.pll", "ghi");
+        ut::expect( ll::update_project_libraries(prj_file.path(), {}, std::ref(issues), nullptr, 2u) );
+        ut::expect( prj_file.content().contains("<![CDATA[ghi]]>"sv) );
+        ut::expect( fs::status(prj_file.path()).permissions()==(fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read) ) << "permissions should be preserved\n";
+        ut::expect( std::ranges::none_of(fsu::list_filenames_in_dir(tmp_dir.path()), [](const std::string& name) noexcept { return name.starts_with(".~"sv); }) ) << "temporary file should be removed\n";
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+       };
+
+    ut::should("update after an empty lib element") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        tmp_dir.create_file("pll1.pll", "abc");
+        tmp_dir.create_file("pll2.pll", "def");
+        const auto prj_file = tmp_dir.create_file("prj.ppjs",
+            "<plcProject>\n"
+            "    <libraries>\n"
+            "        <lib link=\"true\" name=\"pll1.pll\"/>\n"
+            "        <lib link=\"true\" name=\"pll2.pll\"><![CDATA[prev]]></lib>\n"
+            "    </libraries>\n"
+            "</plcProject>\n"sv);
+
+        issueslog_t issues;
+        ut::expect( ll::update_project_libraries(prj_file.path(), {}, std::ref(issues)) );
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( prj_file.content().contains("name=\"pll1.pll\"/>\n"sv) ) << "empty element should be kept\n";
+        ut::expect( prj_file.content().contains("name=\"pll2.pll\"><![CDATA[def]]></lib>"sv) ) << prj_file.content() << '\n';
+       };
+
+    ut::should("update resolving the libraries paths through symlinks") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        fs::create_directories(tmp_dir.path() / "real" / "deep");
+        fs::create_directory_symlink(tmp_dir.path() / "real" / "deep", tmp_dir.path() / "sub");
+        tmp_dir.create_file("real/x.pll", "abc"); // sub/.. is real
+        tmp_dir.create_file("x.pll", "not this"); // Lexically sub/.. is here
+        const auto prj_file = tmp_dir.create_file("prj.ppjs",
+            "<plcProject>\n"
+            "    <libraries>\n"
+            "        <lib link=\"true\" name=\"sub/../x.pll\"></lib>\n"
+            "    </libraries>\n"
+            "</plcProject>\n"sv);
+
+        issueslog_t issues;
+        ut::expect( ll::update_project_libraries(prj_file.path(), {}, std::ref(issues)) );
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( prj_file.content().contains("<![CDATA[abc]]>"sv) ) << prj_file.content() << '\n';
+       };
+
+    ut::should("update in place a symlinked project") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        tmp_dir.create_file("pll1.pll", "abc");
+        const auto prj_file = tmp_dir.create_file("prj.ppjs",
+            "<plcProject>\n"
+            "    <libraries>\n"
+            "        <lib link=\"true\" name=\"pll1.pll\"></lib>\n"
+            "    </libraries>\n"
+            "</plcProject>\n"sv);
+        const fs::path link_path = tmp_dir.path() / "link.ppjs";
+        fs::create_symlink(prj_file.path().filename(), link_path);
+
+        issueslog_t issues;
+        ut::expect( ll::update_project_libraries(link_path, {}, std::ref(issues)) );
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( fs::is_symlink(link_path) ) << "link should be kept\n";
+        ut::expect( prj_file.content().contains("<![CDATA[abc]]>"sv) );
+       };
+
+    ut::should("update skipping the code before libraries") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        tmp_dir.create_file("pll1.pll", "abc");
+        const auto prj_file = tmp_dir.create_file("prj.ppjs",
+            "<plcProject>\n"
+            "<!-- <libraries><lib link=\"true\" name=\"commented.pll\"></lib></libraries> -->\n"
+            "<code><![CDATA[ <libraries> ]]></code>\n"
+            "<libraries>\n"
+            "<lib link=\"false\" name=\"pll1.pll\"></lib>\n"
+            "<lib link=\"true\" name=\"pll1.pll\"></lib>\n"
+            "</libraries>\n"
+            "</plcProject>\n"sv);
+
+        MG::issues issues;
+        ll::update_project_libraries(prj_file.path(), {}, std::ref(issues));
+        ut::expect( ut::that % issues.size()==1u ) << "one issue expected\n";
+        ut::expect( issues.size()==1u and issues.at(0).contains(":5]"sv) ) << "line should be counted\n";
+        ut::expect( prj_file.content().contains("name=\"pll1.pll\"><![CDATA[abc]]>"sv) );
+        ut::expect( prj_file.content().contains("name=\"commented.pll\"></lib>"sv) );
+       };
+
+    ut::should("update reusing the index of an unchanged project") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        tmp_dir.create_file("pll1.pll", "abc");
+        tmp_dir.create_file("pll2.pll", "def");
+        const std::string_view prj_content =
+            "<plcProject>\n"
+            "<libraries>\n"
+            "<lib link=\"true\" name=\"pll1.pll\"></lib>\n"
+            "<lib link=\"true\"\n"
+            "     name=\"pll2.pll\"><![CDATA[prev]]></lib>\n"
+            "</libraries>\n"
+            "</plcProject>\n"sv;
+        const auto prj_file = tmp_dir.create_file("prj.ppjs", prj_content);
+
+        ll::projects_index_cache index_cache;
+        MG::issues issues;
+        const ll::libs_t libs = ll::parse_project_file(prj_file.path(), prj_content, utxt::Enc::UTF8, std::ref(issues), nullptr, &index_cache);
+        const ll::libs_t cached_libs = ll::parse_project_file(prj_file.path(), prj_content, utxt::Enc::UTF8, std::ref(issues), nullptr, &index_cache);
+        ut::expect( ut::that % libs.size()==2u and ut::that % cached_libs.size()==2u and ut::that % index_cache.size()==1u );
+        ut::expect( libs.size()==2u and cached_libs.size()==2u and prj_content.substr(cached_libs[1].chunk_start, cached_libs[1].chunk_end-cached_libs[1].chunk_start)=="<![CDATA[prev]]>"sv );
+        ut::expect( ut::that % issues.size()==0u ) << "no issues expected\n";
+
+        // Same file stamp, but different content
+        const std::string_view changed_content =
+            "<plcProject>\n"
+            "<libraries>\n"
+            "<lib link=\"fals\" name=\"pll1.pll\"></lib>\n"
+            "<lib link=\"true\"\n"
+            "     name=\"pll2.pll\"><![CDATA[prev]]></lib>\n"
+            "</libraries>\n"
+            "</plcProject>\n"sv;
+        const ll::libs_t changed_libs = ll::parse_project_file(prj_file.path(), changed_content, utxt::Enc::UTF8, std::ref(issues), nullptr, &index_cache);
+        ut::expect( ut::that % changed_libs.size()==1u and ut::that % issues.size()==1u );
+        ut::expect( issues.size()==1u and issues.at(0).contains(":3]"sv) ) << "line should be the one of the indexed tag\n";
+       };
+
+    ut::should("update copying big unchanged parts") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        const std::string big_text(3u*sys::file_range_source::min_size, 'x');
+        tmp_dir.create_file("big.pll", big_text);
+        const std::string prj_head = std::format("<plcProject>\n<!-- {} -->\n<libraries>\n<lib link=\"true\" name=\"big.pll\">", big_text);
+        const std::string prj_tail = std::format("</lib>\n</libraries>\n<!-- {} -->\n</plcProject>\n", big_text);
+        const auto prj_file = tmp_dir.create_file("prj.ppjs", std::format("{}prev{}", prj_head, prj_tail));
+
+        issueslog_t issues;
+        ll::update_project_libraries(prj_file.path(), {}, std::ref(issues));
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( prj_file.content() == std::format("{}<![CDATA[{}]]>{}", prj_head, big_text, prj_tail) );
+       };
+
+    ut::should("update preparing the libraries in parallel") = []
+       {
+        test::TemporaryDirectory tmp_dir;
+        std::string prj_content = "<plcProject>\n<libraries>\n";
+        std::string expected = prj_content;
+        for( int i=0; i<20; ++i )
+           {
+            if( i%2==0 )
+               {
+                tmp_dir.create_file(std::format("lib{}.pll", i), std::format("pll{}", i));
+                prj_content += std::format("<lib link=\"true\" name=\"lib{}.pll\"></lib>\n", i);
+                expected += std::format("<lib link=\"true\" name=\"lib{0}.pll\"><![CDATA[pll{0}]]></lib>\n", i);
+               }
+            else
+               {
+                tmp_dir.create_file(std::format("lib{}.plclib", i), std::format("<plc><lib>plclib{}</lib></plc>", i));
+                prj_content += std::format("<lib link=\"true\" name=\"lib{}.plclib\">prev</lib>\n", i);
+                expected += std::format("<lib link=\"true\" name=\"lib{0}.plclib\">plclib{0}</lib>\n", i);
+               }
+           }
+        prj_content += "</libraries>\n</plcProject>\n";
+        expected += "</libraries>\n</plcProject>\n";
+        const auto prj_file = tmp_dir.create_file("prj.ppjs", prj_content);
+
+        issueslog_t issues;
+        ll::update_project_libraries(prj_file.path(), {}, std::ref(issues), nullptr, 4u);
+        ut::expect( ut::that % issues.num==0 ) << "no issues expected\n";
+        ut::expect( ut::that % prj_file.content() == expected );
+
+        tmp_dir.create_file("lib7.plclib", "<lib><lib>forbidden nested</lib></lib>");
+        ut::expect( ut::throws([&prj_file]{ ll::update_project_libraries(prj_file.path(), {}, [](std::string&&)noexcept{}, nullptr, 4u); }) ) << "should throw\n";
        };
    };
 
+ut::test("ll::library_sources") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    fs::create_directory(tmp_dir.path() / "src");
+    fs::create_directory(tmp_dir.path() / "gen");
+    const auto src_pll = tmp_dir.create_file("src/sample-lib.pll", sample_lib_pll);
+    const auto src_h = tmp_dir.create_file("src/sample-def.h", sample_def_header);
+    const std::string_view prj_content =
+        "<plcProject>\n"
+        "<libraries>\n"
+        "<lib link=\"true\" name=\"gen/sample-lib.plclib\"></lib>\n"
+        "<lib link=\"true\" name=\"gen/sample-def.pll\"></lib>\n"
+        "</libraries>\n"
+        "</plcProject>\n"sv;
+    const auto prj_twosteps = tmp_dir.create_file("prj1.ppjs", prj_content);
+    const auto prj_fused = tmp_dir.create_file("prj2.ppjs", prj_content);
+    const MG::options_map conv_options{"plclib-indent:2"};
+
+    // Converting to files and then updating
+    ll::convert_library(src_pll.path(), tmp_dir.path() / "gen", false, conv_options, [](std::string&&)noexcept{});
+    ll::convert_library(src_h.path(), tmp_dir.path() / "gen", false, conv_options, [](std::string&&)noexcept{});
+    MG::issues issues;
+    ll::update_project_libraries(prj_twosteps.path(), {}, std::ref(issues));
+    ut::expect( ut::that % issues.size()==0u );
+    fs::remove_all(tmp_dir.path() / "gen");
+
+    // Converting in memory while updating
+    const ll::library_sources sources({src_pll.path(), src_h.path()}, conv_options);
+    ut::expect( ll::update_project_libraries(prj_fused.path(), {}, std::ref(issues), nullptr, 2u, &sources) );
+    ut::expect( ut::that % issues.size()==0u );
+    ut::expect( ut::that % prj_fused.content()==prj_twosteps.content() );
+    ut::expect( not fs::exists(tmp_dir.path() / "gen") ) << "no intermediate files\n";
+
+    ll::libraries_content_cache cache;
+    ut::expect( not ll::update_project_libraries(prj_fused.path(), {}, std::ref(issues), &cache, 1u, &sources) ) << "already up to date\n";
+    ut::expect( not ll::update_project_libraries(prj_fused.path(), {}, std::ref(issues), &cache, 1u, &sources) );
+    ut::expect( ut::that % cache.size()==2u );
+
+    const auto empty_src = tmp_dir.create_file("src/empty.pll", "\n"sv);
+    const auto prj_empty = tmp_dir.create_file("prj3.ppjs", "<plcProject><libraries><lib link=\"true\" name=\"gen/empty.plclib\"></lib></libraries></plcProject>"sv);
+    const ll::library_sources other_sources({empty_src.path()}, conv_options);
+    ll::update_project_libraries(prj_empty.path(), {}, std::ref(issues), nullptr, 1u, &other_sources);
+    ut::expect( ut::that % issues.size()==1u ) << "conversion issues should be forwarded\n";
+    ut::expect( issues.size()==1u and issues.at(0).contains("empty library"sv) );
+
+    ut::expect( ut::throws([&]{ const ll::library_sources bad_sources({prj_empty.path()}, conv_options); }) ) << "not a source\n";
+   };
+
+ut::test("ll::update_projects_libraries()") = []
+   {
+    test::TemporaryDirectory tmp_dir;
+    fs::create_directory(tmp_dir.path() / "libs");
+    tmp_dir.create_file("libs/common.pll", "common");
+    tmp_dir.create_file("libs/common.plclib", "<plc><lib>plclib</lib></plc>");
+    const std::string_view prj_content =
+        "<plcProject>\n"
+        "<libraries>\n"
+        "<lib link=\"true\" name=\"../libs/common.pll\"></lib>\n"
+        "<lib link=\"true\" name=\"../libs/common.plclib\"></lib>\n"
+        "</libraries>\n"
+        "</plcProject>\n"sv;
+    const std::string_view expected =
+        "<plcProject>\n"
+        "<libraries>\n"
+        "<lib link=\"true\" name=\"../libs/common.pll\"><![CDATA[common]]></lib>\n"
+        "<lib link=\"true\" name=\"../libs/common.plclib\">plclib</lib>\n"
+        "</libraries>\n"
+        "</plcProject>\n"sv;
+    std::vector<fs::path> prj_paths;
+    for( int i=0; i<6; ++i )
+       {
+        fs::create_directory(tmp_dir.path() / std::format("prj{}", i));
+        prj_paths.push_back( tmp_dir.create_file(std::format("prj{0}/prj{0}.ppjs", i), prj_content).path() );
+       }
+
+    ll::libraries_content_cache cache;
+    MG::issues issues;
+    ut::expect( ut::that % ll::update_projects_libraries(prj_paths, 3u, std::ref(issues), &cache)==6u );
+    ut::expect( ut::that % issues.size()==0u );
+    ut::expect( ut::that % cache.size()==2u ) << "libraries should be shared\n";
+    for( const auto& prj_path : prj_paths )
+       {
+        ut::expect( ut::that % test::read_file_content(prj_path.string()) == expected );
+       }
+
+    ut::expect( ut::that % ll::update_projects_libraries(prj_paths, 3u, std::ref(issues), &cache)==0u ) << "already up to date\n";
+
+    // Linking the same library with an absolute path
+    const std::string abs_lib_name = (tmp_dir.path() / "libs" / "common.pll").string();
+    tmp_dir.create_file("prj5/prj5.ppjs", std::format("<plcProject><libraries><lib link=\"true\" name=\"{}\"></lib></libraries></plcProject>", abs_lib_name));
+    ut::expect( ut::that % ll::update_projects_libraries(prj_paths, 3u, std::ref(issues), &cache)==1u );
+    ut::expect( test::read_file_content(prj_paths[5].string()).contains("<![CDATA[common]]>"sv) );
+    ut::expect( ut::that % cache.size()==2u ) << "same library\n";
+    ut::expect( ut::that % issues.size()==0u );
+
+    tmp_dir.create_file("prj4/prj4.ppjs", "<foo>"sv);
+    ut::expect( ut::throws([&]{ [[maybe_unused]] const auto n = ll::update_projects_libraries(prj_paths, 3u, std::ref(issues), &cache); }) ) << "should throw\n";
+
+    // A parse error keeps its location
+    tmp_dir.create_file("libs/bad.plclib", "<lib><lib>forbidden nested</lib></lib>"sv);
+    tmp_dir.create_file("prj4/prj4.ppjs", "<plcProject><libraries><lib link=\"true\" name=\"../libs/bad.plclib\"></lib></libraries></plcProject>"sv);
+    std::string error_file;
+    try{
+        [[maybe_unused]] const auto n = ll::update_projects_libraries(prj_paths, 3u, std::ref(issues), &cache);
+       }
+    catch( parse::error& e )
+       {
+        error_file = e.file();
+       }
+    ut::expect( error_file.ends_with("bad.plclib"sv) ) << "should throw a parse error of the library\n";
+   };
+
 };///////////////////////////////////////////////////////////////////////////
 #endif // TEST_UNITS ////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
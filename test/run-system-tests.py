@@ -979,6 +979,69 @@ class Tests:
             return ret_code==0 and check_file_content(h_pll_path, h_pll) and check_file_content(pll_plclib_path, pll_plclib)
 
 
+    #========================================================================
+    def test_convert_write_if_changed(self):
+        h1 = TextFile('defs1.h', '#define num vn1 // Count\n')
+        h2 = TextFile('defs2.h', '#define str va16 // name\n')
+        with tempfile.TemporaryDirectory() as temp_dir:
+            src_dir = Directory("src", temp_dir)
+            h1.create_in(src_dir.path)
+            h2_path = h2.create_in(src_dir.path)
+            out_dir = Directory("out", temp_dir)
+            outs = [out_dir.decl_file(f) for f in ('defs1.pll', 'defs1.plclib', 'defs2.pll', 'defs2.plclib')]
+            command_and_args = [exe, "convert", os.path.join(src_dir.path,"*.h"), "-p", "write-if-changed", "-v" if self.manual_mode else "-q", "--to", out_dir.path]
+            ret_code, exec_time_ms = launch(command_and_args + ["-F"])
+            if ret_code!=0 or not all(os.path.isfile(out) for out in outs):
+                return False
+            old_time = time.time() - 3600
+            for out in outs: os.utime(out, (old_time, old_time))
+            ret_code, exec_time_ms = launch(command_and_args + ["-F"])
+            if ret_code!=0 or any(os.path.getmtime(out)!=old_time for out in outs):
+                print(f'{RED}Unchanged outputs were rewritten{END}')
+                return False
+            h2.create_with_content_in(src_dir.path, '#define str va16 // changed name\n')
+            ret_code, exec_time_ms = launch(command_and_args) # No need to --force
+            if ret_code!=0 or os.path.getmtime(outs[0])!=old_time or os.path.getmtime(outs[2])==old_time:
+                print(f'{RED}Just the changed outputs should be rewritten{END}')
+                return False
+            return True
+
+
+    #========================================================================
+    def test_convert_watch_single_file(self):
+        h = TextFile('defs.h', '#define num vn1 // Count\n')
+        with tempfile.TemporaryDirectory() as temp_dir:
+            h_path = h.create_in(temp_dir)
+            out_path = os.path.join(temp_dir, "out.plclib")
+            try:
+                subprocess.run([exe, "convert", h_path, "--watch", "-v" if self.manual_mode else "-q", "--to", out_path], timeout=1.5)
+            except subprocess.TimeoutExpired:
+                pass # Watching until killed
+            return os.path.isfile(out_path) # Not a directory
+
+
+    #========================================================================
+    def test_convert_cache_size_overflow(self):
+        h = TextFile('defs.h', '#define num vn1 // Count\n')
+        with tempfile.TemporaryDirectory() as temp_dir:
+            h_path = h.create_in(temp_dir)
+            out_dir = Directory("out", temp_dir)
+            cache_dir = Directory("cache", temp_dir)
+            ret_code, exec_time_ms = launch([exe, "convert", h_path, "--cache-dir", cache_dir.path, "--cache-size", str(2**44), "-v" if self.manual_mode else "-q", "--to", out_dir.path])
+            return ret_code==2 # should complain about the cache size
+
+
+    #========================================================================
+    def test_convert_duplicate_targets(self):
+        h = TextFile('defs.h', '#define num vn1 // Count\n')
+        with tempfile.TemporaryDirectory() as temp_dir:
+            h_path = h.create_in(temp_dir)
+            out_dir = Directory("out", temp_dir)
+            same_dir = os.path.join(temp_dir, "sub", "..", "out")
+            ret_code, exec_time_ms = launch([exe, "convert", h_path, "--target", f"{out_dir.path}=sort", "--target", f"{same_dir}=plclib-indent:2", "-v" if self.manual_mode else "-q"])
+            return ret_code==2 # should complain about the same target given twice
+
+
     #========================================================================
     def test_update_empty(self):
         prj = TextFile('empty.ppjs', '\n')
@@ -11,7 +11,13 @@ namespace ut = boost::ut;
 #include "issues_collector.hpp"
 #include "edit_text_file.hpp"
 #include "project_updater.hpp"
+#include "project_stream_updater.hpp"
+#include "project_extractor.hpp"
 #include "libraries_converter.hpp"
+#include "libraries_watcher.hpp"
+#include "conversion_pipeline.hpp"
+#include "jobs_batch.hpp"
+#include "jobs_server.hpp"
 
 int main()
 {